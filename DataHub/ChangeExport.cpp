@@ -0,0 +1,99 @@
+#include "ChangeExport.h"
+#include "DBControl.h"
+#include "DBError.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStringList>
+
+// Línea JSON de un cambio (las bajas solo llevan la identificación y los
+// reinicios solo el sitio)
+static QByteArray lineaJson(const ComponentChange &cambio)
+{
+    QJsonObject obj;
+    obj.insert("op", cambio.op);
+    obj.insert("seq", cambio.seq);
+    obj.insert("site", cambio.component.site);
+    if (cambio.op == "reset") {
+        return QJsonDocument(obj).toJson(QJsonDocument::Compact) + '\n';
+    }
+    obj.insert("id", cambio.component.id);
+    if (cambio.op != "delete") {
+        obj.insert("name", cambio.component.name);
+        obj.insert("type", cambio.component.type);
+        obj.insert("quantity", cambio.component.quantity);
+        obj.insert("location", cambio.component.location);
+        obj.insert("purchase_date", cambio.component.purchaseDate.toString(Qt::ISODate));
+    }
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact) + '\n';
+}
+
+// Línea CSV de un cambio, con las comillas escapadas como en el reporte
+static QByteArray lineaCsv(const ComponentChange &cambio)
+{
+    const Component &c = cambio.component;
+    QStringList campos = {cambio.op, QString::number(cambio.seq), c.site,
+                          cambio.op == "reset" ? QString() : QString::number(c.id)};
+    if (cambio.op == "insert" || cambio.op == "update") {
+        campos << c.name << c.type << QString::number(c.quantity) << c.location
+               << c.purchaseDate.toString(Qt::ISODate);
+    } else {
+        campos << QString() << QString() << QString() << QString() << QString();
+    }
+
+    QStringList escapados;
+    for (const QString &campo : campos) {
+        QString escaped = campo;
+        escaped.replace("\"", "\"\"");
+        escapados << "\"" + escaped + "\"";
+    }
+    return (escapados.join(",") + "\n").toUtf8();
+}
+
+// Deduce el formato por la extensión del archivo
+ChangeExporter::Formato ChangeExporter::formatoPorExtension(const QString &ruta)
+{
+    return ruta.endsWith(".csv", Qt::CaseInsensitive) ? Csv : JsonLines;
+}
+
+// Escribe los cambios en 'ruta' y confirma la marca del consumidor
+bool ChangeExporter::exportar(DatabaseManager &db, const QString &ruta, Formato formato,
+                              const QString &consumidor, int *filas, QString *error)
+{
+    // QSaveFile solo reemplaza el destino si todo se escribió bien
+    QSaveFile archivo(ruta);
+    if (!archivo.open(QIODevice::WriteOnly)) {
+        fijarError(error, QString("No se pudo crear %1").arg(ruta));
+        return false;
+    }
+
+    if (formato == Csv) {
+        archivo.write("op,seq,sitio,id,nombre,tipo,cantidad,ubicacion,fecha\n");
+    }
+
+    // Cada cambio se escribe según se lee, sin acumular el lote en memoria
+    int exportadas = 0;
+    QVector<qint64> marcas;
+    const bool leido = db.readChanges(consumidor, [&](const ComponentChange &cambio) {
+        ++exportadas;
+        const QByteArray linea = formato == Csv ? lineaCsv(cambio) : lineaJson(cambio);
+        return archivo.write(linea) == linea.size();
+    }, &marcas);
+
+    if (!leido) {
+        archivo.cancelWriting();
+    }
+    if (!leido || !archivo.commit()) {
+        fijarError(error, QString("Error al exportar los cambios a %1").arg(ruta));
+        return false;
+    }
+
+    // La marca solo avanza cuando el archivo ya está en disco
+    if (!db.commitWatermarks(consumidor, marcas)) {
+        fijarError(error, "No se pudo guardar la marca de exportación");
+        return false;
+    }
+
+    if (filas) *filas = exportadas;
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef CHANGEEXPORTER_H
+#define CHANGEEXPORTER_H
+
+#include <QString>
+
+class DatabaseManager;
+
+// Exportación incremental para sistemas externos (ERP).
+// Escribe solo los componentes insertados, modificados o eliminados desde la
+// última exportación confirmada del consumidor, leyendo el diario de cambios de
+// DatabaseManager. El coste es proporcional al número de cambios.
+// Un consumidor nuevo recibe primero el catálogo completo de cada almacén: una
+// línea "reset" (el consumidor descarta lo que tenga de ese sitio) y una línea
+// "insert" por componente; a partir de ahí, solo los cambios.
+class ChangeExporter
+{
+public:
+    // Formato del archivo de cambios
+    enum Formato {
+        JsonLines, // Un objeto JSON por línea
+        Csv        // Cabecera y una fila por cambio
+    };
+
+    // Deduce el formato por la extensión (".csv" -> Csv; cualquier otra -> JsonLines)
+    static Formato formatoPorExtension(const QString &ruta);
+
+    // Escribe los cambios en 'ruta' y, solo si el archivo se completa, avanza la
+    // marca del consumidor. En 'filas' deja el número de cambios exportados
+    static bool exportar(DatabaseManager &db, const QString &ruta, Formato formato,
+                         const QString &consumidor = "erp", int *filas = nullptr,
+                         QString *error = nullptr);
+};
+
+#endif // CHANGEEXPORTER_H
@@ -0,0 +1,643 @@
+#include "DBBackup.h"
+#include "DBError.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <sqlite3.h>
+
+// Formato del archivo de respaldo (.ibk)
+static const quint32 MAGIC_RESPALDO = 0x494E5642; // "INVB"
+static const quint16 VERSION_RESPALDO = 2; // 2: añade el nombre de la base de datos de origen
+static const char *EXTENSION_RESPALDO = ".ibk";
+
+// Páginas copiadas por cada llamada a sqlite3_backup_step
+static const int PAGINAS_POR_PASO = 64;
+
+// Incrementales encadenados antes de forzar un respaldo completo
+static const quint32 MAX_CADENA = 8;
+
+// Reintentos (de 20 ms) cuando la base de datos está ocupada
+static const int MAX_REINTENTOS_OCUPADA = 500;
+
+// Veces que la copia puede volver a empezar porque otra conexión escribió en el
+// origen; después se copia el resto en un solo paso, bloqueando a los escritores
+static const int MAX_REINICIOS_COPIA = 5;
+
+// Línea que escribe el modo consola por cada respaldo creado
+static const QString PREFIJO_RESPALDO_CREADO = "Respaldo creado: ";
+
+namespace {
+
+// Cabecera de un archivo de respaldo
+struct Cabecera {
+    bool incremental = false;
+    QString base;            // Nombre del respaldo anterior (solo incrementales)
+    quint32 cadena = 0;      // Posición en la cadena (0 = completo)
+    qint64 creado = 0;       // Fecha de creación en milisegundos desde epoch
+    quint32 tamPagina = 0;
+    quint32 numPaginas = 0;
+    QByteArray hashes;       // MD5 de cada página (16 bytes por página)
+    QByteArray sha256;       // SHA-256 de la imagen completa de la base de datos
+    QString origen;          // Nombre del archivo respaldado (vacío en la versión 1)
+};
+
+} // namespace
+
+// Escribe la cabecera de un respaldo
+static void escribirCabecera(QDataStream &out, const Cabecera &cab)
+{
+    out << MAGIC_RESPALDO << VERSION_RESPALDO
+        << quint8(cab.incremental ? 1 : 0) << cab.base << cab.cadena << cab.creado
+        << cab.tamPagina << cab.numPaginas << cab.hashes << cab.sha256 << cab.origen;
+}
+
+// Lee y valida la cabecera de un respaldo
+static bool leerCabecera(QDataStream &in, Cabecera &cab)
+{
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint8 incremental = 0;
+    in >> magic >> version;
+    if (magic != MAGIC_RESPALDO || version < 1 || version > VERSION_RESPALDO) return false;
+
+    in >> incremental >> cab.base >> cab.cadena >> cab.creado
+       >> cab.tamPagina >> cab.numPaginas >> cab.hashes >> cab.sha256;
+    cab.incremental = incremental != 0;
+    cab.origen.clear();
+    if (version >= 2) in >> cab.origen;
+
+    return in.status() == QDataStream::Ok && cab.tamPagina > 0
+        && cab.hashes.size() == qint64(cab.numPaginas) * 16;
+}
+
+// Abre un respaldo y lee solo su cabecera
+static bool leerCabeceraArchivo(const QString &ruta, Cabecera &cab)
+{
+    QFile archivo(ruta);
+    if (!archivo.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&archivo);
+    in.setVersion(QDataStream::Qt_5_12);
+    return leerCabecera(in, cab);
+}
+
+// Copia origen en destino con la API de backup de SQLite. Con paginasPorPaso > 0
+// los bloqueos sobre el origen solo duran un paso y entre pasos se cede el turno
+// a los escritores; con -1 la copia se hace de una vez.
+// SQLite vuelve a empezar la copia cada vez que otra conexión escribe en el origen,
+// así que con escrituras continuas podría no terminar nunca: tras
+// MAX_REINICIOS_COPIA reinicios el resto se copia en un solo paso.
+static bool copiarConBackup(const QString &origen, const QString &destino,
+                            int paginasPorPaso, QString *error)
+{
+    sqlite3 *src = nullptr;
+    sqlite3 *dst = nullptr;
+    bool ok = false;
+
+    int rc = sqlite3_open_v2(origen.toUtf8().constData(), &src,
+                             SQLITE_OPEN_READONLY, nullptr);
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_open_v2(destino.toUtf8().constData(), &dst,
+                             SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
+    }
+
+    if (rc != SQLITE_OK) {
+        fijarError(error, QString("No se pudo abrir %1: %2")
+                              .arg(dst ? destino : origen,
+                                   QString::fromUtf8(sqlite3_errmsg(dst ? dst : src))));
+    } else if (sqlite3_backup *backup = sqlite3_backup_init(dst, "main", src, "main")) {
+        int reintentos = 0;
+        int reinicios = 0;
+        int paso = paginasPorPaso;
+        int restantes = -1;
+        do {
+            rc = sqlite3_backup_step(backup, paso);
+            if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+                if (++reintentos > MAX_REINTENTOS_OCUPADA) break;
+                sqlite3_sleep(20);
+            } else if (rc == SQLITE_OK) {
+                reintentos = 0;
+
+                // Un reinicio deja la copia de nuevo al principio: quedan casi todas las páginas
+                const int ahora = sqlite3_backup_remaining(backup);
+                if (restantes >= 0 && ahora > restantes
+                    && sqlite3_backup_pagecount(backup) - ahora <= paso
+                    && ++reinicios >= MAX_REINICIOS_COPIA) {
+                    qWarning() << "La copia de" << origen << "se reinició" << reinicios
+                               << "veces; se completa en un solo paso";
+                    paso = -1;
+                }
+                restantes = ahora;
+                sqlite3_sleep(1); // Deja pasar a los escritores entre pasos
+            }
+        } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+        const int fin = sqlite3_backup_finish(backup);
+        ok = rc == SQLITE_DONE && fin == SQLITE_OK;
+        if (!ok) {
+            fijarError(error, QString("Error al copiar %1: %2")
+                                  .arg(origen, QString::fromUtf8(sqlite3_errstr(rc))));
+        }
+    } else {
+        fijarError(error, QString("No se pudo iniciar la copia: %1")
+                              .arg(QString::fromUtf8(sqlite3_errmsg(dst))));
+    }
+
+    sqlite3_close(src);
+    sqlite3_close(dst);
+    return ok;
+}
+
+// Ejecuta PRAGMA integrity_check sobre una base de datos
+static bool comprobarIntegridad(const QString &ruta, QString *error)
+{
+    sqlite3 *db = nullptr;
+    sqlite3_stmt *stmt = nullptr;
+    QString resultado;
+
+    if (sqlite3_open_v2(ruta.toUtf8().constData(), &db, SQLITE_OPEN_READWRITE, nullptr) == SQLITE_OK
+        && sqlite3_prepare_v2(db, "PRAGMA integrity_check", -1, &stmt, nullptr) == SQLITE_OK
+        && sqlite3_step(stmt) == SQLITE_ROW) {
+        resultado = QString::fromUtf8(
+            reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
+    } else {
+        resultado = QString::fromUtf8(sqlite3_errmsg(db));
+    }
+
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+
+    if (resultado != "ok") {
+        fijarError(error, QString("Integridad incorrecta en %1: %2").arg(ruta, resultado));
+        return false;
+    }
+    return true;
+}
+
+// Vacía las marcas de exportación de una base de datos (si tiene la tabla), para
+// que cada consumidor reciba el catálogo completo en su próxima exportación
+static bool reiniciarMarcasExportacion(const QString &ruta, QString *error)
+{
+    sqlite3 *db = nullptr;
+    bool ok = sqlite3_open_v2(ruta.toUtf8().constData(), &db, SQLITE_OPEN_READWRITE, nullptr)
+              == SQLITE_OK;
+    const bool tieneTabla = ok && sqlite3_table_column_metadata(db, "main", "export_watermarks",
+                                                                nullptr, nullptr, nullptr,
+                                                                nullptr, nullptr, nullptr)
+                                      == SQLITE_OK;
+    if (tieneTabla) {
+        ok = sqlite3_exec(db, "DELETE FROM export_watermarks", nullptr, nullptr, nullptr)
+             == SQLITE_OK;
+    }
+    if (!ok) {
+        fijarError(error, QString("No se pudieron reiniciar las marcas de exportación: %1")
+                              .arg(QString::fromUtf8(sqlite3_errmsg(db))));
+    }
+    sqlite3_close(db);
+    return ok;
+}
+
+// Función SQL que solo existe en las conexiones abiertas por esta copia de SQLite
+static void funcionMarcaSqlite(sqlite3_context *contexto, int, sqlite3_value **)
+{
+    sqlite3_result_int(contexto, 1);
+}
+
+// Extensión automática que registra funcionMarcaSqlite en cada conexión nueva
+static int registrarMarcaSqlite(sqlite3 *db, char **, const sqlite3_api_routines *)
+{
+    return sqlite3_create_function(db, "inventario_marca_sqlite", 0, SQLITE_UTF8, nullptr,
+                                   funcionMarcaSqlite, nullptr, nullptr);
+}
+
+// Borra un archivo de base de datos junto con sus archivos auxiliares
+static void borrarBaseDeDatos(const QString &ruta)
+{
+    QFile::remove(ruta);
+    QFile::remove(ruta + "-journal");
+    QFile::remove(ruta + "-wal");
+    QFile::remove(ruta + "-shm");
+}
+
+// Tamaño de página según la cabecera de SQLite (bytes 16-17, big endian)
+static quint32 tamanoDePagina(QFile &imagen)
+{
+    imagen.seek(0);
+    const QByteArray cabecera = imagen.read(100);
+    if (cabecera.size() < 100) return 0;
+    const quint32 tam = (quint32(quint8(cabecera[16])) << 8) | quint8(cabecera[17]);
+    return tam == 1 ? 65536 : tam;
+}
+
+// Nombre exacto de los respaldos de una base de datos: "<base>-yyyyMMdd-HHmmsszzz.ibk".
+// Un prefijo con comodín también aceptaría los de otro almacén ("inventario-norte-...")
+static QRegularExpression patronRespaldos(const QString &dbPath)
+{
+    return QRegularExpression(
+        "^" + QRegularExpression::escape(QFileInfo(dbPath).completeBaseName())
+        + "-\\d{8}-\\d{9}" + QRegularExpression::escape(EXTENSION_RESPALDO) + "$");
+}
+
+// Respaldos de una base de datos en un directorio, del más antiguo al más reciente
+static QStringList respaldosDe(const QDir &dir, const QString &dbPath)
+{
+    const QRegularExpression patron = patronRespaldos(dbPath);
+    QStringList respaldos;
+    for (const QString &nombre : dir.entryList({"*" + QString(EXTENSION_RESPALDO)},
+                                               QDir::Files, QDir::Name)) {
+        if (patron.match(nombre).hasMatch()) respaldos << nombre;
+    }
+    return respaldos;
+}
+
+// Reconstruye en imagenDestino la base de datos de un respaldo, aplicando en
+// orden el respaldo completo y los incrementales de su cadena, y comprueba la
+// suma SHA-256 y la integridad del resultado.
+static bool reconstruir(const QString &archivo, const QString &imagenDestino, QString *error)
+{
+    // Recorre la cadena hacia atrás hasta llegar al respaldo completo.
+    // Todos los eslabones deben venir de la misma base de datos
+    QStringList cadena;
+    QString actual = archivo;
+    QString origen;
+    Cabecera cab;
+    for (;;) {
+        if (!leerCabeceraArchivo(actual, cab)) {
+            fijarError(error, QString("Respaldo ilegible: %1").arg(actual));
+            return false;
+        }
+        if (cadena.isEmpty()) {
+            origen = cab.origen;
+        } else if (cab.origen != origen) {
+            fijarError(error, QString("La cadena de %1 mezcla respaldos de otra base de datos (%2)")
+                                  .arg(archivo, actual));
+            return false;
+        }
+        cadena.prepend(actual);
+        if (!cab.incremental) break;
+        if (cadena.size() > 1000) {
+            fijarError(error, QString("Cadena de respaldos inválida: %1").arg(archivo));
+            return false;
+        }
+        actual = QFileInfo(actual).dir().filePath(cab.base);
+    }
+
+    borrarBaseDeDatos(imagenDestino);
+    QFile imagen(imagenDestino);
+    if (!imagen.open(QIODevice::ReadWrite)) {
+        fijarError(error, QString("No se pudo crear %1").arg(imagenDestino));
+        return false;
+    }
+
+    for (const QString &ruta : cadena) {
+        QFile respaldo(ruta);
+        if (!respaldo.open(QIODevice::ReadOnly)) {
+            fijarError(error, QString("No se pudo abrir %1").arg(ruta));
+            return false;
+        }
+        QDataStream in(&respaldo);
+        in.setVersion(QDataStream::Qt_5_12);
+        if (!leerCabecera(in, cab)) {
+            fijarError(error, QString("Respaldo ilegible: %1").arg(ruta));
+            return false;
+        }
+
+        // Las páginas que no vienen en el archivo se conservan del respaldo anterior
+        imagen.resize(qint64(cab.numPaginas) * cab.tamPagina);
+
+        quint32 guardadas = 0;
+        in >> guardadas;
+        for (quint32 i = 0; i < guardadas && in.status() == QDataStream::Ok; ++i) {
+            quint32 numero = 0;
+            QByteArray comprimida;
+            in >> numero >> comprimida;
+            const QByteArray pagina = qUncompress(comprimida);
+            if (numero >= cab.numPaginas || pagina.size() != int(cab.tamPagina)) {
+                fijarError(error, QString("Página %1 dañada en %2").arg(numero).arg(ruta));
+                return false;
+            }
+            imagen.seek(qint64(numero) * cab.tamPagina);
+            imagen.write(pagina);
+        }
+        if (in.status() != QDataStream::Ok) {
+            fijarError(error, QString("Respaldo truncado: %1").arg(ruta));
+            return false;
+        }
+    }
+
+    // La imagen reconstruida debe coincidir con la del último respaldo de la cadena
+    imagen.seek(0);
+    QCryptographicHash sha(QCryptographicHash::Sha256);
+    sha.addData(&imagen);
+    imagen.close();
+    if (sha.result() != cab.sha256) {
+        fijarError(error, QString("La suma SHA-256 no coincide: %1").arg(archivo));
+        return false;
+    }
+
+    return comprobarIntegridad(imagenDestino, error);
+}
+
+// Constructor
+BackupManager::BackupManager(QObject *parent) : QObject(parent) {}
+
+// Comprueba que el controlador QSQLITE usa esta misma copia de SQLite: se registra
+// una extensión automática en la biblioteca enlazada y se mira si una conexión
+// abierta por Qt la ve. Con dos copias en el mismo proceso, cerrar un archivo
+// desde una libera los bloqueos POSIX de la otra y la base de datos puede dañarse.
+bool BackupManager::sqliteCompartidaConQt(QString *error)
+{
+    static const bool compartida = []() {
+        sqlite3_auto_extension(reinterpret_cast<void (*)()>(registrarMarcaSqlite));
+        bool ok = false;
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "respaldo_comprobacion");
+            db.setDatabaseName(":memory:");
+            if (db.open()) {
+                QSqlQuery query(db);
+                ok = query.exec("SELECT inventario_marca_sqlite()") && query.next();
+            }
+            db.close();
+        }
+        QSqlDatabase::removeDatabase("respaldo_comprobacion");
+        sqlite3_cancel_auto_extension(reinterpret_cast<void (*)()>(registrarMarcaSqlite));
+        return ok;
+    }();
+
+    if (!compartida) {
+        fijarError(error, QString("El controlador QSQLITE usa su propia copia de SQLite (la "
+                                  "enlazada es %1); los respaldos se hacen en un proceso aparte")
+                              .arg(QString::fromUtf8(sqlite3_libversion())));
+    }
+    return compartida;
+}
+
+// Ejecuta la propia aplicación en modo consola y espera a que termine. El error
+// es la salida de error del proceso (donde fijarError deja los mensajes)
+static bool ejecutarModoConsola(const QStringList &argumentos, QString *error)
+{
+    QProcess proceso;
+    proceso.start(QCoreApplication::applicationFilePath(), argumentos);
+    if (!proceso.waitForStarted() || !proceso.waitForFinished(-1)) {
+        fijarError(error, "No se pudo ejecutar el proceso de respaldo: " + proceso.errorString());
+        return false;
+    }
+    if (proceso.exitStatus() != QProcess::NormalExit || proceso.exitCode() != 0) {
+        const QString salida = QString::fromLocal8Bit(proceso.readAllStandardError()).trimmed();
+        fijarError(error, salida.isEmpty() ? QString("El proceso de respaldo terminó con error")
+                                           : salida);
+        return false;
+    }
+    return true;
+}
+
+// Con una sola copia de SQLite se restaura en este proceso; si no, la propia
+// aplicación lo hace en modo consola (en otro proceso los bloqueos de archivo no
+// se pisan con los de las conexiones abiertas aquí)
+bool BackupManager::restaurarConAplicacionAbierta(const QString &archivoRespaldo,
+                                                  const QString &dbPath, QString *error)
+{
+    if (sqliteCompartidaConQt()) {
+        return restaurar(archivoRespaldo, dbPath, error);
+    }
+    return ejecutarModoConsola({"--db", dbPath, "--restaurar", archivoRespaldo}, error);
+}
+
+// Destructor: espera a que termine el respaldo en curso
+BackupManager::~BackupManager()
+{
+    if (m_hilo) {
+        m_hilo->wait();
+    }
+    if (m_proceso) {
+        m_proceso->waitForFinished(-1);
+    }
+}
+
+// Crea un respaldo de dbPath en dirDestino.
+// 1. Copia en línea la base de datos a un archivo temporal (API de backup).
+// 2. Calcula el MD5 de cada página y lo compara con el último respaldo.
+// 3. Escribe solo las páginas cambiadas (o todas, si es completo) comprimidas.
+QString BackupManager::crearRespaldo(const QString &dbPath, const QString &dirDestino,
+                                     QString *error)
+{
+    QDir dir(dirDestino);
+    if (!dir.mkpath(".")) {
+        fijarError(error, QString("No se pudo crear el directorio %1").arg(dirDestino));
+        return QString();
+    }
+
+    const QString prefijo = QFileInfo(dbPath).completeBaseName();
+    const QDateTime ahora = QDateTime::currentDateTime();
+    const QString nombre = prefijo + "-" + ahora.toString("yyyyMMdd-HHmmsszzz") + EXTENSION_RESPALDO;
+    const QString temporal = dir.filePath(nombre + ".tmp");
+
+    if (!copiarConBackup(dbPath, temporal, PAGINAS_POR_PASO, error)) {
+        borrarBaseDeDatos(temporal);
+        return QString();
+    }
+
+    QFile imagen(temporal);
+    if (!imagen.open(QIODevice::ReadOnly)) {
+        fijarError(error, QString("No se pudo leer la copia %1").arg(temporal));
+        borrarBaseDeDatos(temporal);
+        return QString();
+    }
+
+    Cabecera cab;
+    cab.creado = ahora.toMSecsSinceEpoch();
+    cab.origen = QFileInfo(dbPath).fileName();
+    cab.tamPagina = tamanoDePagina(imagen);
+    if (cab.tamPagina == 0) {
+        fijarError(error, QString("Copia inválida de %1").arg(dbPath));
+        borrarBaseDeDatos(temporal);
+        return QString();
+    }
+    cab.numPaginas = quint32(imagen.size() / cab.tamPagina);
+
+    // Primera pasada: hash de cada página y de la imagen completa
+    QCryptographicHash sha(QCryptographicHash::Sha256);
+    cab.hashes.reserve(int(cab.numPaginas) * 16);
+    imagen.seek(0);
+    for (quint32 i = 0; i < cab.numPaginas; ++i) {
+        const QByteArray pagina = imagen.read(cab.tamPagina);
+        sha.addData(pagina);
+        cab.hashes.append(QCryptographicHash::hash(pagina, QCryptographicHash::Md5));
+    }
+    cab.sha256 = sha.result();
+
+    // Se encadena al último respaldo si es compatible y la cadena no es demasiado larga
+    const QStringList anteriores = respaldosDe(dir, dbPath);
+    Cabecera base;
+    if (!anteriores.isEmpty()
+        && leerCabeceraArchivo(dir.filePath(anteriores.last()), base)
+        && base.origen == cab.origen
+        && base.tamPagina == cab.tamPagina && base.cadena + 1 < MAX_CADENA) {
+        cab.incremental = true;
+        cab.base = anteriores.last();
+        cab.cadena = base.cadena + 1;
+    }
+
+    QVector<quint32> cambiadas;
+    for (quint32 i = 0; i < cab.numPaginas; ++i) {
+        if (!cab.incremental || i >= base.numPaginas
+            || cab.hashes.mid(int(i) * 16, 16) != base.hashes.mid(int(i) * 16, 16)) {
+            cambiadas.append(i);
+        }
+    }
+
+    // Segunda pasada: escribe las páginas seleccionadas de forma atómica
+    QSaveFile salida(dir.filePath(nombre));
+    if (!salida.open(QIODevice::WriteOnly)) {
+        fijarError(error, QString("No se pudo crear %1").arg(salida.fileName()));
+        borrarBaseDeDatos(temporal);
+        return QString();
+    }
+    QDataStream out(&salida);
+    out.setVersion(QDataStream::Qt_5_12);
+    escribirCabecera(out, cab);
+    out << quint32(cambiadas.size());
+    for (quint32 numero : cambiadas) {
+        imagen.seek(qint64(numero) * cab.tamPagina);
+        out << numero << qCompress(imagen.read(cab.tamPagina), 6);
+    }
+
+    imagen.close();
+    borrarBaseDeDatos(temporal);
+
+    if (out.status() != QDataStream::Ok || !salida.commit()) {
+        fijarError(error, QString("Error al escribir %1").arg(salida.fileName()));
+        return QString();
+    }
+    return dir.filePath(nombre);
+}
+
+// Comprueba el origen de la cabecera; los respaldos de la versión 1 no lo
+// guardan y se reconocen por el nombre del archivo
+bool BackupManager::esRespaldoDe(const QString &archivoRespaldo, const QString &dbPath)
+{
+    Cabecera cab;
+    if (!leerCabeceraArchivo(archivoRespaldo, cab)) return false;
+    if (!cab.origen.isEmpty()) return cab.origen == QFileInfo(dbPath).fileName();
+    return patronRespaldos(dbPath).match(QFileInfo(archivoRespaldo).fileName()).hasMatch();
+}
+
+// Reconstruye el respaldo en un archivo temporal y comprueba que sea correcto
+bool BackupManager::verificar(const QString &archivoRespaldo, QString *error)
+{
+    const QString temporal = archivoRespaldo + ".verificando";
+    const bool ok = reconstruir(archivoRespaldo, temporal, error);
+    borrarBaseDeDatos(temporal);
+    return ok;
+}
+
+// Verifica el respaldo y lo copia sobre dbPath. La copia usa la API de backup,
+// así que las conexiones abiertas sobre dbPath ven el contenido restaurado.
+// El diario de cambios vuelve al estado del respaldo, así que se borran las
+// marcas de exportación: cada consumidor recibirá de nuevo el catálogo completo.
+bool BackupManager::restaurar(const QString &archivoRespaldo, const QString &dbPath,
+                              QString *error)
+{
+    if (!esRespaldoDe(archivoRespaldo, dbPath)) {
+        fijarError(error, QString("El respaldo %1 no es de %2")
+                              .arg(archivoRespaldo, QFileInfo(dbPath).fileName()));
+        return false;
+    }
+
+    const QString temporal = dbPath + ".restaurando";
+    bool ok = reconstruir(archivoRespaldo, temporal, error)
+              && reiniciarMarcasExportacion(temporal, error)
+              && copiarConBackup(temporal, dbPath, -1, error);
+    borrarBaseDeDatos(temporal);
+    return ok;
+}
+
+// Respalda cada base de datos en un hilo de fondo, o en un proceso hijo si QSQLITE
+// usa otra copia de SQLite
+void BackupManager::respaldarEnSegundoPlano(const QStringList &dbPaths, const QString &dirDestino)
+{
+    if (ocupado()) return; // Ya hay un respaldo en curso
+    if (!sqliteCompartidaConQt()) {
+        respaldarEnProceso(dbPaths, dirDestino);
+        return;
+    }
+
+    m_hilo = QThread::create([this, dbPaths, dirDestino]() {
+        for (const QString &dbPath : dbPaths) {
+            QString error;
+            const QString archivo = crearRespaldo(dbPath, dirDestino, &error);
+            emit respaldoTerminado(!archivo.isEmpty(), archivo.isEmpty() ? error : archivo);
+        }
+    });
+    connect(m_hilo, &QThread::finished, this, [this]() {
+        m_hilo->deleteLater();
+        m_hilo = nullptr;
+    });
+    m_hilo->start(QThread::LowPriority);
+}
+
+// La propia aplicación en modo consola hace los respaldos; por cada línea
+// "Respaldo creado" se emite respaldoTerminado y, si falla, una vez con el error
+void BackupManager::respaldarEnProceso(const QStringList &dbPaths, const QString &dirDestino)
+{
+    m_proceso = new QProcess(this);
+    auto terminar = [this](bool ok, const QString &archivoOError) {
+        if (!ok) emit respaldoTerminado(false, archivoOError);
+        m_proceso->deleteLater();
+        m_proceso = nullptr;
+    };
+
+    connect(m_proceso, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, terminar](int codigo, QProcess::ExitStatus estado) {
+        const QString salida = QString::fromLocal8Bit(m_proceso->readAllStandardOutput());
+        for (const QString &linea : salida.split('\n')) {
+            if (linea.startsWith(PREFIJO_RESPALDO_CREADO)) {
+                emit respaldoTerminado(true, linea.mid(PREFIJO_RESPALDO_CREADO.size()).trimmed());
+            }
+        }
+        const QString error = QString::fromLocal8Bit(m_proceso->readAllStandardError()).trimmed();
+        const bool ok = estado == QProcess::NormalExit && codigo == 0;
+        terminar(ok, error.isEmpty() ? QString("El proceso de respaldo terminó con error") : error);
+    });
+    connect(m_proceso, &QProcess::errorOccurred, this, [this, terminar](QProcess::ProcessError fallo) {
+        if (fallo != QProcess::FailedToStart) return; // El resto lo informa finished
+        terminar(false, "No se pudo ejecutar el proceso de respaldo: " + m_proceso->errorString());
+    });
+
+    // El modo consola respalda la base de datos principal y los almacenes de su
+    // inventario.ini, que son los mismos que ha abierto la aplicación
+    m_proceso->start(QCoreApplication::applicationFilePath(),
+                     {"--db", dbPaths.value(0), "--respaldo", dirDestino});
+}
+
+// Repite el respaldo en segundo plano cada 'minutos'
+void BackupManager::programar(const QStringList &dbPaths, const QString &dirDestino, int minutos)
+{
+    m_dbsProgramadas = dbPaths;
+    m_dirProgramado = dirDestino;
+
+    if (!m_temporizador) {
+        m_temporizador = new QTimer(this);
+        connect(m_temporizador, &QTimer::timeout, this, [this]() {
+            respaldarEnSegundoPlano(m_dbsProgramadas, m_dirProgramado);
+        });
+    }
+
+    if (minutos > 0) {
+        m_temporizador->start(minutos * 60 * 1000);
+    } else {
+        m_temporizador->stop();
+    }
+}
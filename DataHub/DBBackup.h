@@ -0,0 +1,87 @@
+#ifndef BACKUPMANAGER_H
+#define BACKUPMANAGER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QProcess;
+class QThread;
+class QTimer;
+
+// Respaldo y restauración en línea de la base de datos SQLite.
+//
+// La copia se hace con la API de backup de SQLite (sqlite3_backup_step) sobre una
+// conexión propia, avanzando pocas páginas por paso para que los escritores no
+// queden bloqueados. Cada respaldo se guarda como un archivo .ibk comprimido:
+// el primero de cada cadena es completo y los siguientes solo contienen las
+// páginas que cambiaron respecto al anterior.
+//
+// Las funciones abren la base de datos con la biblioteca SQLite enlazada. En un
+// proceso que también la tiene abierta con QSQLITE, ambas deben ser la misma copia
+// (ver sqliteCompartidaConQt); si no lo son, respaldarEnSegundoPlano y
+// restaurarConAplicacionAbierta ejecutan la propia aplicación en modo consola.
+class BackupManager : public QObject
+{
+    Q_OBJECT
+public:
+    // Constructor explícito, permite pasar un QObject padre
+    explicit BackupManager(QObject *parent = nullptr);
+
+    // Destructor: espera a que termine el respaldo en curso
+    ~BackupManager();
+
+    // Crea un respaldo de dbPath en dirDestino. Devuelve la ruta del archivo
+    // creado o una cadena vacía si falla (el motivo se deja en error)
+    static QString crearRespaldo(const QString &dbPath, const QString &dirDestino,
+                                 QString *error = nullptr);
+
+    // Reconstruye el respaldo y comprueba su suma SHA-256 y su integridad
+    static bool verificar(const QString &archivoRespaldo, QString *error = nullptr);
+
+    // Verifica el respaldo y, solo si es correcto, lo copia sobre dbPath. Las marcas
+    // de exportación se borran: el diario de cambios retrocede con los datos
+    static bool restaurar(const QString &archivoRespaldo, const QString &dbPath,
+                          QString *error = nullptr);
+
+    // restaurar() para una base de datos que esta aplicación tiene abierta: si QSQLITE
+    // usa otra copia de SQLite, la restauración se hace en un proceso aparte
+    static bool restaurarConAplicacionAbierta(const QString &archivoRespaldo,
+                                             const QString &dbPath, QString *error = nullptr);
+
+    // Indica si el respaldo es de la base de datos dbPath, según el origen guardado
+    // en la cabecera (o, en respaldos de la versión 1, según el nombre del archivo)
+    static bool esRespaldoDe(const QString &archivoRespaldo, const QString &dbPath);
+
+    // Indica si QSQLITE usa la misma copia de SQLite que estas funciones
+    // (requisito para respaldar o restaurar una base de datos abierta con Qt)
+    static bool sqliteCompartidaConQt(QString *error = nullptr);
+
+    // Respalda cada base de datos (una por almacén) en un hilo de fondo, o en un
+    // proceso hijo si QSQLITE usa otra copia de SQLite (la primera ruta debe ser la
+    // principal: el proceso respalda todos los almacenes de su inventario.ini).
+    // Se ignora si ya hay un respaldo en curso
+    void respaldarEnSegundoPlano(const QStringList &dbPaths, const QString &dirDestino);
+
+    // Repite el respaldo en segundo plano cada 'minutos' (0 desactiva la programación)
+    void programar(const QStringList &dbPaths, const QString &dirDestino, int minutos);
+
+    // Indica si hay un respaldo en curso
+    bool ocupado() const { return m_hilo != nullptr || m_proceso != nullptr; }
+
+signals:
+    // Se emite al terminar cada respaldo: ruta del archivo si ok, mensaje de error si no
+    void respaldoTerminado(bool ok, const QString &archivoOError);
+
+private:
+    // Respalda ejecutando la aplicación en modo consola
+    void respaldarEnProceso(const QStringList &dbPaths, const QString &dirDestino);
+
+    QThread *m_hilo = nullptr;          // Hilo del respaldo en curso
+    QProcess *m_proceso = nullptr;      // Proceso del respaldo en curso
+    QTimer *m_temporizador = nullptr;   // Temporizador de la programación periódica
+    QStringList m_dbsProgramadas;       // Bases de datos del respaldo programado
+    QString m_dirProgramado;            // Directorio del respaldo programado
+};
+
+#endif // BACKUPMANAGER_H
@@ -6,82 +6,507 @@
 #include <QStringList>
 #include <QDate>
 #include <QObject>
+#include <QAtomicInt>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <algorithm>
+#include <queue>
+#include <utility>
+#include <vector>
 
 // Nombre de la conexión para evitar duplicados en QSqlDatabase
 static const QString CONNECTION_NAME = "main_connection";
 
+// Prefijo de las conexiones de los almacenes adicionales
+static const QString SHARD_CONNECTION_PREFIX = "shard_";
+
+// Configuración de los almacenes, junto a la base de datos principal
+static const QString CONFIG_FILE = "inventario.ini";
+
+// Contador para dar nombres únicos a las conexiones de los hilos de trabajo
+static QAtomicInt s_conexionesHilo;
+
+// Contador de instancias: cada DatabaseManager usa sus propias conexiones, así que
+// puede haber uno por hilo (por ejemplo, en las pruebas de concurrencia)
+static QAtomicInt s_instancias;
+
+// Versión del esquema guardada en PRAGMA user_version
+// (0 = fechas como TEXT ISO, 1 = fechas como día juliano INTEGER)
+static const int SCHEMA_VERSION = 1;
+
+// Columnas que se leen de components, en el orden que espera leerComponente
+static const QString COMPONENT_COLUMNS = "id, name, type, quantity, location, purchase_day";
+
+// Construye un componente a partir de COMPONENT_COLUMNS, empezando en 'primera'
+static Component leerComponente(const QSqlQuery &query, int primera, const QString &sitio) {
+    Component component;
+    component.id = query.value(primera).toLongLong();
+    component.name = query.value(primera + 1).toString();
+    component.type = query.value(primera + 2).toString();
+    component.quantity = query.value(primera + 3).toInt();
+    component.location = query.value(primera + 4).toString();
+    component.purchaseDate = QDate::fromJulianDay(query.value(primera + 5).toLongLong());
+    component.site = sitio;
+    return component;
+}
+
+// Lee todas las filas de una consulta sobre COMPONENT_COLUMNS
+static QVector<Component> leerComponentes(QSqlQuery &query, const QString &sitio) {
+    QVector<Component> components;
+    while (query.next()) {
+        components.append(leerComponente(query, 0, sitio));
+    }
+    return components;
+}
+
+// Ejecuta una consulta de solo avance (QSQLITE no guarda en memoria las filas leídas)
+static bool ejecutarLectura(QSqlQuery &query, const QString &sql,
+                            const QVariantList &valores = QVariantList()) {
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    for (const QVariant &valor : valores) {
+        query.addBindValue(valor);
+    }
+    if (!query.exec()) {
+        qCritical() << "Error en la consulta:" << query.lastError();
+        return false;
+    }
+    return true;
+}
+
+// Criterios de orden de los resultados
+static bool menorPorNombre(const Component &a, const Component &b) {
+    return a.name < b.name;
+}
+
+static bool menorPorFecha(const Component &a, const Component &b) {
+    return a.purchaseDate < b.purchaseDate;
+}
+
+// Recorre en orden k listas ya ordenadas según 'menor' y entrega cada fila al
+// visitante (que devuelve false para parar). Un montículo guarda el cursor de
+// cada lista, así que cada fila se compara O(log k) veces. La mezcla no es en
+// flujo: cada almacén devuelve su resultado completo desde su hilo y se mezcla
+// al terminar todos, así que la memoria es proporcional al total de filas.
+template <typename Menor, typename Visitante>
+static void recorrerOrdenadas(const QVector<QVector<Component>> &listas, Menor menor,
+                              Visitante visitante) {
+    using Cursor = std::pair<int, int>; // (lista, posición)
+    auto vaDespues = [&listas, menor](const Cursor &a, const Cursor &b) {
+        const Component &filaA = listas[a.first][a.second];
+        const Component &filaB = listas[b.first][b.second];
+        if (menor(filaB, filaA)) return true;
+        if (menor(filaA, filaB)) return false;
+        return a.first > b.first;
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(vaDespues)> monticulo(vaDespues);
+
+    for (int i = 0; i < listas.size(); ++i) {
+        if (!listas[i].isEmpty()) monticulo.push({i, 0});
+    }
+    while (!monticulo.empty()) {
+        Cursor cursor = monticulo.top();
+        monticulo.pop();
+        if (!visitante(listas[cursor.first][cursor.second])) return;
+        if (++cursor.second < listas[cursor.first].size()) monticulo.push(cursor);
+    }
+}
+
+// Mezcla k listas ya ordenadas según 'menor' en una sola
+template <typename Menor>
+static QVector<Component> mezclarOrdenadas(const QVector<QVector<Component>> &listas,
+                                           Menor menor) {
+    int total = 0;
+    for (const QVector<Component> &lista : listas) total += lista.size();
+
+    QVector<Component> resultado;
+    resultado.reserve(total);
+    recorrerOrdenadas(listas, menor, [&resultado](const Component &c) {
+        resultado.append(c);
+        return true;
+    });
+    return resultado;
+}
+
 // Constructor de la clase DatabaseManager
-DatabaseManager::DatabaseManager(QObject *parent) : QObject(parent) {}
+DatabaseManager::DatabaseManager(QObject *parent)
+    : QObject(parent), m_pool(new QThreadPool(this)),
+      m_instance(s_instancias.fetchAndAddRelaxed(1)) {}
+
+// Nombre de conexión propio de esta instancia
+QString DatabaseManager::connectionName(const QString &base) const {
+    return QString("%1#%2").arg(base).arg(m_instance);
+}
 
 // Inicializa la base de datos SQLite en la ruta especificada
-bool DatabaseManager::initialize(const QString &databasePath) {
+bool DatabaseManager::initialize(const QString &databasePath, const QString &site) {
+    m_shards.clear();
+    if (!openShard(site, databasePath, connectionName(CONNECTION_NAME))) {
+        return false;
+    }
+    m_db = m_shards.first().db;
+    return true;
+}
+
+// Añade otro almacén con su propio archivo de base de datos
+bool DatabaseManager::addShard(const QString &site, const QString &databasePath) {
+    if (site.isEmpty() || shardIndex(site) >= 0) {
+        qCritical() << "Sitio de almacén inválido o repetido:" << site;
+        return false;
+    }
+    for (const QString &ruta : databasePaths()) {
+        if (mismoNombreDeArchivo(ruta, databasePath)) {
+            qCritical() << "El almacén" << site << "usa el mismo nombre de archivo que" << ruta;
+            return false;
+        }
+    }
+    return openShard(site, databasePath, connectionName(SHARD_CONNECTION_PREFIX + site));
+}
+
+// Inicializa el almacén principal y los adicionales según inventario.ini
+bool DatabaseManager::initializeFromConfig(const QString &databasePath, QStringList *failedSites) {
+    const QDir dir = QFileInfo(databasePath).dir();
+    QSettings config(dir.filePath(CONFIG_FILE), QSettings::IniFormat);
+
+    if (!initialize(databasePath, config.value("sitioPrincipal", "Principal").toString())) {
+        return false;
+    }
+
+    config.beginGroup("almacenes");
+    for (const QString &sitio : config.childKeys()) {
+        if (!addShard(sitio, dir.absoluteFilePath(config.value(sitio).toString()))
+            && failedSites) {
+            failedSites->append(sitio);
+        }
+    }
+    config.endGroup();
+    return true;
+}
+
+QStringList DatabaseManager::configuredDatabasePaths(const QString &databasePath) {
+    const QDir dir = QFileInfo(databasePath).dir();
+    QSettings config(dir.filePath(CONFIG_FILE), QSettings::IniFormat);
+
+    // Se omiten, igual que en addShard, los almacenes con un nombre de archivo repetido
+    QStringList rutas = {databasePath};
+    config.beginGroup("almacenes");
+    for (const QString &sitio : config.childKeys()) {
+        const QString ruta = dir.absoluteFilePath(config.value(sitio).toString());
+        const bool repetida = std::any_of(rutas.cbegin(), rutas.cend(), [&](const QString &otra) {
+            return mismoNombreDeArchivo(otra, ruta);
+        });
+        if (repetida) {
+            qCritical() << "El almacén" << sitio << "usa un nombre de archivo repetido:" << ruta;
+            continue;
+        }
+        rutas << ruta;
+    }
+    config.endGroup();
+    return rutas;
+}
+
+// Abre (o reutiliza) una conexión con nombre y crea sus tablas
+bool DatabaseManager::openShard(const QString &site, const QString &databasePath,
+                                const QString &connectionName) {
     // Usa una conexión nombrada para evitar duplicados
-    if (QSqlDatabase::contains(CONNECTION_NAME)) {
-        m_db = QSqlDatabase::database(CONNECTION_NAME);
+    QSqlDatabase db;
+    if (QSqlDatabase::contains(connectionName)) {
+        db = QSqlDatabase::database(connectionName);
     } else {
-        m_db = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+        db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
     }
-    m_db.setDatabaseName(databasePath);
+    db.setDatabaseName(databasePath);
 
     // Intenta abrir la base de datos
-    if (!m_db.open()) {
-        qCritical() << "Error al abrir DB:" << m_db.lastError();
+    if (!db.open()) {
+        qCritical() << "Error al abrir DB:" << site << db.lastError();
         return false;
     }
     // Crea las tablas si no existen
-    return createTables();
+    if (!createTables(db)) {
+        return false;
+    }
+    m_shards.append({site, db});
+    return true;
 }
 
-// Crea la tabla de componentes si no existe
-bool DatabaseManager::createTables() {
-    QSqlQuery query(m_db);
-    return query.exec(
+// Los respaldos identifican su base de datos por el nombre del archivo (sin
+// directorio ni extensión), así que dos almacenes no pueden compartirlo
+bool DatabaseManager::mismoNombreDeArchivo(const QString &a, const QString &b) {
+    return QFileInfo(a).completeBaseName().compare(QFileInfo(b).completeBaseName(),
+                                                   Qt::CaseInsensitive) == 0;
+}
+
+// Nombres de los almacenes, empezando por el principal
+QStringList DatabaseManager::sites() const {
+    QStringList nombres;
+    for (const Shard &shard : m_shards) nombres << shard.site;
+    return nombres;
+}
+
+// Rutas de los archivos de todos los almacenes
+QStringList DatabaseManager::databasePaths() const {
+    QStringList rutas;
+    for (const Shard &shard : m_shards) rutas << shard.db.databaseName();
+    return rutas;
+}
+
+// Posición del almacén en sites() (-1 si no existe)
+int DatabaseManager::shardIndex(const QString &site) const {
+    for (int i = 0; i < m_shards.size(); ++i) {
+        if (m_shards[i].site == site) return i;
+    }
+    return -1;
+}
+
+// Conexión del almacén indicado (sitio vacío = principal)
+QSqlDatabase DatabaseManager::shardDb(const QString &site) const {
+    if (site.isEmpty()) return m_db;
+    const int i = shardIndex(site);
+    if (i < 0) {
+        qCritical() << "Almacén desconocido:" << site;
+        return QSqlDatabase();
+    }
+    return m_shards[i].db;
+}
+
+// Ejecuta la consulta en cada almacén. Con varios almacenes cada uno se consulta
+// en un hilo del pool con su propia conexión de solo lectura, porque una
+// QSqlDatabase solo puede usarse en el hilo que la abrió.
+template <typename T, typename Fn>
+QVector<T> DatabaseManager::fanOut(Fn consulta) const {
+    QVector<T> resultados(m_shards.size());
+
+    // Con un solo almacén se consulta directamente sobre la conexión principal
+    if (m_shards.size() == 1) {
+        QSqlDatabase db = m_shards.first().db;
+        resultados[0] = consulta(db, m_shards.first().site);
+        return resultados;
+    }
+
+    T *destino = resultados.data();
+    QSemaphore terminadas;
+    for (int i = 0; i < m_shards.size(); ++i) {
+        const QString ruta = m_shards[i].db.databaseName();
+        const QString sitio = m_shards[i].site;
+        m_pool->start([consulta, destino, i, ruta, sitio, &terminadas]() {
+            const QString nombre = QString("fanout_%1").arg(s_conexionesHilo.fetchAndAddRelaxed(1));
+            {
+                QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", nombre);
+                db.setDatabaseName(ruta);
+                db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+                if (db.open()) {
+                    destino[i] = consulta(db, sitio);
+                } else {
+                    qCritical() << "Error al abrir almacén" << sitio << db.lastError();
+                }
+                db.close();
+            }
+            QSqlDatabase::removeDatabase(nombre);
+            terminadas.release();
+        });
+    }
+    terminadas.acquire(m_shards.size());
+    return resultados;
+}
+
+// Crea la tabla de componentes y el diario de cambios si no existen.
+// Los triggers anotan en component_changes cada alta, modificación y baja con
+// una secuencia creciente, que es lo que recorre la exportación incremental.
+// Las fechas se guardan como día juliano (INTEGER) con un índice que cubre
+// todas las columnas, de modo que las consultas por rango de fechas son
+// recorridos de rango sobre el índice sin acceder a la tabla.
+bool DatabaseManager::createTables(QSqlDatabase &db) {
+    QSqlQuery query(db);
+
+    const QStringList sentencias = {
         "CREATE TABLE IF NOT EXISTS components ("
         "id INTEGER PRIMARY KEY AUTOINCREMENT,"
         "name TEXT NOT NULL,"
         "type TEXT NOT NULL,"
         "quantity INTEGER NOT NULL,"
         "location TEXT NOT NULL,"
-        "purchase_date TEXT NOT NULL)"
-    );
+        "purchase_day INTEGER NOT NULL)", // Día juliano (QDate::toJulianDay)
+
+        "CREATE INDEX IF NOT EXISTS idx_components_purchase_day ON components "
+        "(purchase_day, id, name, type, quantity, location)",
+
+        "CREATE TABLE IF NOT EXISTS component_changes ("
+        "seq INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "component_id INTEGER NOT NULL,"
+        "op TEXT NOT NULL)", // 'I', 'U' o 'D'
+
+        "CREATE TABLE IF NOT EXISTS export_watermarks ("
+        "consumer TEXT PRIMARY KEY,"
+        "seq INTEGER NOT NULL)",
+
+        "CREATE TRIGGER IF NOT EXISTS components_journal_insert AFTER INSERT ON components "
+        "BEGIN INSERT INTO component_changes (component_id, op) VALUES (NEW.id, 'I'); END",
+
+        "CREATE TRIGGER IF NOT EXISTS components_journal_update AFTER UPDATE ON components "
+        "BEGIN INSERT INTO component_changes (component_id, op) VALUES (NEW.id, 'U'); END",
+
+        "CREATE TRIGGER IF NOT EXISTS components_journal_delete AFTER DELETE ON components "
+        "BEGIN INSERT INTO component_changes (component_id, op) VALUES (OLD.id, 'D'); END"
+    };
+
+    // BEGIN IMMEDIATE toma el bloqueo de escritura antes de leer el esquema: si
+    // otra conexión abre el mismo archivo a la vez, espera (busy timeout) a que
+    // termine y luego ve el esquema ya migrado en lugar de migrarlo otra vez.
+    // Con BEGIN diferido las dos leerían la versión antigua y la segunda
+    // fallaría con SQLITE_BUSY al intentar escribir.
+    if (!query.exec("BEGIN IMMEDIATE")) {
+        qCritical() << "Error al bloquear la base de datos:" << query.lastError();
+        return false;
+    }
+
+    // Si el diario es nuevo se siembra con las filas existentes como altas
+    query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'component_changes'");
+    const bool diarioNuevo = !query.next();
+
+    query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'components'");
+    const bool hayComponentes = query.next();
+
+    query.exec("PRAGMA user_version");
+    const int version = query.next() ? query.value(0).toInt() : 0;
+
+    if (hayComponentes && version < SCHEMA_VERSION && !migrateToDayNumbers(query)) {
+        db.rollback();
+        return false;
+    }
+    for (const QString &sql : sentencias) {
+        if (!query.exec(sql)) {
+            qCritical() << "Error al crear tablas:" << query.lastError();
+            db.rollback();
+            return false;
+        }
+    }
+    if (diarioNuevo
+        && !query.exec("INSERT INTO component_changes (component_id, op) "
+                       "SELECT id, 'I' FROM components ORDER BY id")) {
+        qCritical() << "Error al sembrar el diario de cambios:" << query.lastError();
+        db.rollback();
+        return false;
+    }
+    if (version < SCHEMA_VERSION
+        && !query.exec(QString("PRAGMA user_version = %1").arg(SCHEMA_VERSION))) {
+        qCritical() << "Error al fijar la versión del esquema:" << query.lastError();
+        db.rollback();
+        return false;
+    }
+    return db.commit();
+}
+
+// Migra la tabla antigua (purchase_date TEXT) a purchase_day INTEGER.
+// SQLite no permite cambiar el tipo de una columna, así que se copia a una tabla
+// nueva y se renombra; los triggers del diario se recrean después en createTables.
+// Se conserva el contador AUTOINCREMENT para no reutilizar IDs ya exportados.
+// Si alguna fecha no se puede interpretar la migración falla sin tocar nada:
+// un día por defecto aparecería en los informes de antigüedad como una compra real.
+bool DatabaseManager::migrateToDayNumbers(QSqlQuery &query) {
+    if (!query.exec("SELECT id, purchase_date FROM components "
+                    "WHERE julianday(purchase_date) IS NULL ORDER BY id LIMIT 10")) {
+        qCritical() << "Error al comprobar las fechas:" << query.lastError();
+        return false;
+    }
+    QStringList invalidas;
+    while (query.next()) {
+        invalidas << QString("%1 (\"%2\")").arg(query.value(0).toString(),
+                                                query.value(1).toString());
+    }
+    if (!invalidas.isEmpty()) {
+        qCritical() << "No se puede migrar: fechas de compra no válidas en los componentes"
+                    << invalidas.join(", ");
+        return false;
+    }
+
+    query.exec("SELECT seq FROM sqlite_sequence WHERE name = 'components'");
+    const QVariant ultimoId = query.next() ? query.value(0) : QVariant();
+
+    const QStringList sentencias = {
+        "CREATE TABLE components_v1 ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "name TEXT NOT NULL,"
+        "type TEXT NOT NULL,"
+        "quantity INTEGER NOT NULL,"
+        "location TEXT NOT NULL,"
+        "purchase_day INTEGER NOT NULL)",
+
+        // julianday() cuenta desde el mediodía: +0.5 da el día juliano de QDate
+        "INSERT INTO components_v1 (id, name, type, quantity, location, purchase_day) "
+        "SELECT id, name, type, CAST(quantity AS INTEGER), location, "
+        "CAST(julianday(purchase_date) + 0.5 AS INTEGER) FROM components",
+
+        "DROP TABLE components",
+        "ALTER TABLE components_v1 RENAME TO components"
+    };
+    for (const QString &sql : sentencias) {
+        if (!query.exec(sql)) {
+            qCritical() << "Error al migrar las fechas:" << query.lastError();
+            return false;
+        }
+    }
+
+    if (ultimoId.isValid()) {
+        query.prepare("UPDATE sqlite_sequence SET seq = MAX(seq, ?) WHERE name = 'components'");
+        query.addBindValue(ultimoId);
+        bool ok = query.exec();
+        if (ok && query.numRowsAffected() == 0) {
+            query.prepare("INSERT INTO sqlite_sequence (name, seq) VALUES ('components', ?)");
+            query.addBindValue(ultimoId);
+            ok = query.exec();
+        }
+        if (!ok) {
+            qCritical() << "Error al conservar el contador de IDs:" << query.lastError();
+            return false;
+        }
+    }
+    return true;
 }
 
 // Inserta un nuevo componente en la base de datos
 bool DatabaseManager::addComponent(const QString &name, const QString &type,
                                    int quantity, const QString &location,
-                                   const QDate &purchaseDate) {
-    QSqlQuery query(m_db);
+                                   const QDate &purchaseDate, const QString &site,
+                                   qint64 *newId) {
+    QSqlQuery query(shardDb(site));
     query.prepare(
-        "INSERT INTO components (name, type, quantity, location, purchase_date) "
-        "VALUES (:name, :type, :quantity, :location, :date)"
+        "INSERT INTO components (name, type, quantity, location, purchase_day) "
+        "VALUES (:name, :type, :quantity, :location, :day)"
     );
     query.bindValue(":name", name);
     query.bindValue(":type", type);
     query.bindValue(":quantity", quantity);
     query.bindValue(":location", location);
-    query.bindValue(":date", purchaseDate.toString(Qt::ISODate));
+    query.bindValue(":day", purchaseDate.toJulianDay());
 
     // Ejecuta la consulta y verifica si fue exitosa
     if (!query.exec()) {
         qCritical() << "Error al insertar:" << query.lastError();
         return false;
     }
+    if (newId) *newId = query.lastInsertId().toLongLong();
     return true;
 }
 
 // Actualiza un componente existente en la base de datos
-bool DatabaseManager::actualizarComponente(int id, const QString& nombre,
+bool DatabaseManager::actualizarComponente(qint64 id, const QString& nombre,
                                            const QString& tipo, int cantidad,
                                            const QString& ubicacion,
-                                           const QDate& fecha) {
-    QSqlQuery query(m_db);
+                                           const QDate& fecha,
+                                           const QString& sitio) {
+    QSqlQuery query(shardDb(sitio));
     query.prepare(
         "UPDATE components SET "
         "name = :name, "
         "type = :type, "
         "quantity = :quantity, "
         "location = :location, "
-        "purchase_date = :date "
+        "purchase_day = :day "
         "WHERE id = :id"
     );
 
@@ -90,34 +515,263 @@ bool DatabaseManager::actualizarComponente(int id, const QString& nombre,
     query.bindValue(":type", tipo);
     query.bindValue(":quantity", cantidad);
     query.bindValue(":location", ubicacion);
-    query.bindValue(":date", fecha.toString(Qt::ISODate));
+    query.bindValue(":day", fecha.toJulianDay());
 
     // Ejecuta la consulta de actualización
     return query.exec();
 }
 
-// Obtiene todos los componentes de la base de datos y los devuelve como una lista de listas de strings
-QVector<QStringList> DatabaseManager::getAllComponents() const {
-    QVector<QStringList> components;
-    QSqlQuery query("SELECT * FROM components ORDER BY name", m_db);
+// Obtiene todos los componentes de todos los almacenes, ordenados por nombre
+QVector<Component> DatabaseManager::getAllComponents() const {
+    const QVector<QVector<Component>> porAlmacen = fanOut<QVector<Component>>(
+        [](QSqlDatabase &db, const QString &sitio) {
+            QSqlQuery query(db);
+            if (!ejecutarLectura(query, "SELECT " + COMPONENT_COLUMNS +
+                                        " FROM components ORDER BY name")) {
+                return QVector<Component>();
+            }
+            return leerComponentes(query, sitio);
+        });
+    return mezclarOrdenadas(porAlmacen, menorPorNombre);
+}
 
-    // Recorre los resultados y los agrega a la lista
+// Busca por nombre, tipo o ubicación en todos los almacenes, ordenado por nombre
+QVector<Component> DatabaseManager::searchComponents(const QString &texto) const {
+    // Escapa los comodines de LIKE para buscar el texto literal
+    QString patron = texto;
+    patron.replace("\\", "\\\\").replace("%", "\\%").replace("_", "\\_");
+    patron = "%" + patron + "%";
+
+    const QVector<QVector<Component>> porAlmacen = fanOut<QVector<Component>>(
+        [patron](QSqlDatabase &db, const QString &sitio) {
+            QSqlQuery query(db);
+            if (!ejecutarLectura(query, "SELECT " + COMPONENT_COLUMNS + " FROM components "
+                                        "WHERE name LIKE ? ESCAPE '\\' OR type LIKE ? ESCAPE '\\' "
+                                        "OR location LIKE ? ESCAPE '\\' ORDER BY name",
+                                 {patron, patron, patron})) {
+                return QVector<Component>();
+            }
+            return leerComponentes(query, sitio);
+        });
+    return mezclarOrdenadas(porAlmacen, menorPorNombre);
+}
+
+// Componentes comprados entre dos fechas en todos los almacenes, ordenados por fecha
+QVector<Component> DatabaseManager::componentsPurchasedBetween(const QDate &desde,
+                                                               const QDate &hasta) const {
+    QVector<Component> resultado;
+    componentsPurchasedBetween(desde, hasta, [&resultado](const Component &c) {
+        resultado.append(c);
+        return true;
+    });
+    return resultado;
+}
+
+// Recorre las compras entre dos fechas sin construir la lista mezclada.
+// La condición es un rango sobre idx_components_purchase_day (sin conversiones)
+void DatabaseManager::componentsPurchasedBetween(
+    const QDate &desde, const QDate &hasta,
+    const std::function<bool(const Component &)> &visitor) const {
+    const qint64 diaDesde = desde.toJulianDay();
+    const qint64 diaHasta = hasta.toJulianDay();
+
+    const QVector<QVector<Component>> porAlmacen = fanOut<QVector<Component>>(
+        [diaDesde, diaHasta](QSqlDatabase &db, const QString &sitio) {
+            QSqlQuery query(db);
+            if (!ejecutarLectura(query, "SELECT " + COMPONENT_COLUMNS + " FROM components "
+                                        "WHERE purchase_day BETWEEN ? AND ? ORDER BY purchase_day",
+                                 {diaDesde, diaHasta})) {
+                return QVector<Component>();
+            }
+            return leerComponentes(query, sitio);
+        });
+    recorrerOrdenadas(porAlmacen, menorPorFecha, visitor);
+}
+
+// Componentes comprados hace más de 'dias' días, del más antiguo al más reciente
+QVector<Component> DatabaseManager::componentsOlderThan(int dias) const {
+    QVector<Component> resultado;
+    componentsOlderThan(dias, [&resultado](const Component &c) {
+        resultado.append(c);
+        return true;
+    });
+    return resultado;
+}
+
+// Recorre los componentes comprados hace más de 'dias' días sin construir la lista mezclada
+void DatabaseManager::componentsOlderThan(
+    int dias, const std::function<bool(const Component &)> &visitor) const {
+    const qint64 limite = QDate::currentDate().addDays(-dias).toJulianDay();
+
+    const QVector<QVector<Component>> porAlmacen = fanOut<QVector<Component>>(
+        [limite](QSqlDatabase &db, const QString &sitio) {
+            QSqlQuery query(db);
+            if (!ejecutarLectura(query, "SELECT " + COMPONENT_COLUMNS + " FROM components "
+                                        "WHERE purchase_day < ? ORDER BY purchase_day",
+                                 {limite})) {
+                return QVector<Component>();
+            }
+            return leerComponentes(query, sitio);
+        });
+    recorrerOrdenadas(porAlmacen, menorPorFecha, visitor);
+}
+
+// Suma de cantidades por tipo en todos los almacenes
+QMap<QString, int> DatabaseManager::cantidadPorTipo() const {
+    const QVector<QMap<QString, int>> porAlmacen = fanOut<QMap<QString, int>>(
+        [](QSqlDatabase &db, const QString &) {
+            QMap<QString, int> totales;
+            QSqlQuery query("SELECT type, SUM(quantity) FROM components GROUP BY type", db);
+            while (query.next()) {
+                totales.insert(query.value(0).toString(), query.value(1).toInt());
+            }
+            return totales;
+        });
+
+    QMap<QString, int> totales;
+    for (const QMap<QString, int> &parcial : porAlmacen) {
+        for (auto it = parcial.constBegin(); it != parcial.constEnd(); ++it) {
+            totales[it.key()] += it.value();
+        }
+    }
+    return totales;
+}
+
+// Recorre los cambios posteriores a la marca del consumidor, almacén por almacén.
+// Por cada componente tocado se entrega un único cambio con su estado actual;
+// los creados y borrados dentro del mismo intervalo se omiten.
+bool DatabaseManager::readChanges(const QString &consumer,
+                                  const std::function<bool(const ComponentChange &)> &visitor,
+                                  QVector<qint64> *newWatermarks) const {
+    newWatermarks->clear();
+
+    for (const Shard &shard : m_shards) {
+        QSqlQuery query(shard.db);
+        query.setForwardOnly(true);
+
+        query.prepare("SELECT seq FROM export_watermarks WHERE consumer = ?");
+        query.addBindValue(consumer);
+        if (!query.exec()) {
+            qCritical() << "Error al leer la marca de exportación:" << query.lastError();
+            return false;
+        }
+        const bool registrado = query.next();
+        const qint64 desde = registrado ? query.value(0).toLongLong() : 0;
+
+        // Se fija el límite superior para que la marca nueva sea coherente con lo leído.
+        // sqlite_sequence conserva la última secuencia aunque el diario esté podado
+        if (!query.exec("SELECT MAX(COALESCE((SELECT MAX(seq) FROM component_changes), 0), "
+                        "COALESCE((SELECT seq FROM sqlite_sequence "
+                        "          WHERE name = 'component_changes'), 0))")
+            || !query.next()) {
+            qCritical() << "Error al leer el diario de cambios:" << query.lastError();
+            return false;
+        }
+        const qint64 hasta = query.value(0).toLongLong();
+        newWatermarks->append(qMax(desde, hasta));
+
+        // Un consumidor nuevo no puede partir del diario, que ya puede estar podado
+        // por otros consumidores: recibe el catálogo completo
+        if (!registrado) {
+            if (!readSnapshot(shard, hasta, visitor)) return false;
+            continue;
+        }
+        if (hasta <= desde) continue;
+
+        // Búsqueda por rango sobre la clave primaria del diario: el coste depende
+        // del número de cambios, no del tamaño del catálogo
+        query.prepare(
+            "SELECT u.last_seq, u.component_id, f.op AS first_op, "
+            "k.id, k.name, k.type, k.quantity, k.location, k.purchase_day "
+            "FROM (SELECT component_id, MIN(seq) AS first_seq, MAX(seq) AS last_seq "
+            "      FROM component_changes WHERE seq > ? AND seq <= ? "
+            "      GROUP BY component_id) u "
+            "JOIN component_changes f ON f.seq = u.first_seq "
+            "LEFT JOIN components k ON k.id = u.component_id "
+            "ORDER BY u.last_seq"
+        );
+        query.addBindValue(desde);
+        query.addBindValue(hasta);
+        if (!query.exec()) {
+            qCritical() << "Error al leer el diario de cambios:" << query.lastError();
+            return false;
+        }
+
+        while (query.next()) {
+            const bool existe = !query.value("id").isNull();
+            const bool alta = query.value("first_op").toString() == "I";
+            if (!existe && alta) continue; // Creado y borrado dentro del intervalo
+
+            ComponentChange cambio;
+            cambio.seq = query.value("last_seq").toLongLong();
+            cambio.op = !existe ? "delete" : (alta ? "insert" : "update");
+            if (existe) {
+                cambio.component = leerComponente(query, 3, shard.site);
+            } else {
+                cambio.component.id = query.value("component_id").toLongLong();
+                cambio.component.site = shard.site;
+            }
+            if (!visitor(cambio)) return false;
+        }
+    }
+    return true;
+}
+
+// Entrega una instantánea de un almacén: un cambio "reset" seguido de un "insert"
+// por cada componente. Lo que cambie durante la lectura vuelve a salir en la
+// siguiente exportación, porque su secuencia es posterior a 'hasta'.
+bool DatabaseManager::readSnapshot(const Shard &shard, qint64 hasta,
+                                   const std::function<bool(const ComponentChange &)> &visitor) const {
+    ComponentChange reinicio;
+    reinicio.seq = hasta;
+    reinicio.op = "reset";
+    reinicio.component.site = shard.site;
+    if (!visitor(reinicio)) return false;
+
+    QSqlQuery query(shard.db);
+    if (!ejecutarLectura(query, "SELECT " + COMPONENT_COLUMNS + " FROM components ORDER BY id")) {
+        return false;
+    }
     while (query.next()) {
-        QStringList component;
-        component << query.value("id").toString()
-                  << query.value("name").toString()
-                  << query.value("type").toString()
-                  << query.value("quantity").toString()
-                  << query.value("location").toString()
-                  << query.value("purchase_date").toString();
-        components.append(component);
+        ComponentChange cambio;
+        cambio.seq = hasta;
+        cambio.op = "insert";
+        cambio.component = leerComponente(query, 0, shard.site);
+        if (!visitor(cambio)) return false;
     }
-    return components;
+    return true;
+}
+
+// Guarda las marcas del consumidor y poda del diario lo que ya exportaron todos
+bool DatabaseManager::commitWatermarks(const QString &consumer,
+                                       const QVector<qint64> &watermarks) {
+    if (watermarks.size() != m_shards.size()) return false;
+
+    for (int i = 0; i < m_shards.size(); ++i) {
+        QSqlDatabase db = m_shards[i].db;
+        QSqlQuery query(db);
+        db.transaction();
+
+        query.prepare("INSERT OR REPLACE INTO export_watermarks (consumer, seq) VALUES (?, ?)");
+        query.addBindValue(consumer);
+        query.addBindValue(watermarks[i]);
+        bool ok = query.exec();
+
+        ok = ok && query.exec("DELETE FROM component_changes "
+                              "WHERE seq <= (SELECT MIN(seq) FROM export_watermarks)");
+        if (!ok) {
+            qCritical() << "Error al guardar la marca de exportación:" << query.lastError();
+            db.rollback();
+            return false;
+        }
+        db.commit();
+    }
+    return true;
 }
 
 // Elimina un componente de la base de datos por su ID
-bool DatabaseManager::eliminarComponente(const QString &id) {
-    QSqlQuery query(m_db);
+bool DatabaseManager::eliminarComponente(qint64 id, const QString &sitio) {
+    QSqlQuery query(shardDb(sitio));
     query.prepare("DELETE FROM components WHERE id = :id");
     query.bindValue(":id", id);
     return query.exec();
@@ -128,9 +782,21 @@ QSqlError DatabaseManager::lastError() const {
     return m_db.lastError();
 }
 
-// Destructor: cierra la base de datos si está abierta
+// Destructor: cierra las bases de datos y libera sus conexiones
 DatabaseManager::~DatabaseManager() {
-    if (m_db.isOpen()) {
-        m_db.close();
+    m_pool->waitForDone();
+    QStringList conexiones;
+    for (Shard &shard : m_shards) {
+        if (shard.db.isOpen()) {
+            shard.db.close();
+        }
+        conexiones << shard.db.connectionName();
+    }
+
+    // removeDatabase exige que no quede ninguna copia de la conexión en uso
+    m_shards.clear();
+    m_db = QSqlDatabase();
+    for (const QString &nombre : conexiones) {
+        QSqlDatabase::removeDatabase(nombre);
     }
 }
\ No newline at end of file
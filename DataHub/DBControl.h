@@ -5,8 +5,34 @@
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QDate>
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+#include <functional>
 
-// Clase que gestiona la conexión y operaciones con la base de datos
+class QThreadPool;
+
+// Componente del inventario con sus valores tipados
+struct Component {
+    qint64 id = 0;
+    QString name;
+    QString type;
+    int quantity = 0;
+    QString location;
+    QDate purchaseDate;
+    QString site;            // Almacén en el que está
+};
+
+// Cambio de un componente registrado en el diario (tabla component_changes)
+struct ComponentChange {
+    qint64 seq = 0;          // Secuencia del último cambio del componente
+    QString op;              // "insert", "update", "delete" o "reset" (ver readChanges)
+    Component component;     // Datos actuales (solo id y site si se eliminó)
+};
+
+// Clase que gestiona la conexión y operaciones con la base de datos.
+// Cada almacén (sitio) tiene su propio archivo SQLite; las lecturas se reparten
+// entre todos los almacenes en paralelo y sus resultados se mezclan en orden.
 class DatabaseManager : public QObject
 {
     Q_OBJECT
@@ -17,33 +43,132 @@ public:
     // Destructor
     ~DatabaseManager();
 
-    // Inicializa la base de datos en la ruta especificada (por defecto "inventario.db")
-    bool initialize(const QString &databasePath = "inventario.db");
+    // Inicializa la base de datos en la ruta especificada (por defecto "inventario.db").
+    // Esta base de datos es el almacén principal, con el nombre de sitio indicado
+    bool initialize(const QString &databasePath = "inventario.db",
+                    const QString &site = "Principal");
+
+    // Añade otro almacén con su propio archivo de base de datos. Falla si el nombre
+    // del archivo coincide con el de otro almacén aunque estén en otro directorio
+    // (los respaldos se distinguen por ese nombre)
+    bool addShard(const QString &site, const QString &databasePath);
+
+    // Inicializa el almacén principal y los adicionales según inventario.ini (junto a
+    // la base de datos): clave sitioPrincipal y sección [almacenes] con líneas sitio=ruta.
+    // Solo falla si no se abre el principal; los sitios que fallen se dejan en failedSites
+    bool initializeFromConfig(const QString &databasePath, QStringList *failedSites = nullptr);
 
-    // Agrega un nuevo componente a la base de datos
+    // Rutas de todos los almacenes según inventario.ini, empezando por databasePath,
+    // sin abrir ninguna base de datos (para respaldar o restaurar desde la consola).
+    // Omite los almacenes que addShard rechazaría por nombre de archivo repetido
+    static QStringList configuredDatabasePaths(const QString &databasePath);
+
+    // Nombres de los almacenes, empezando por el principal
+    QStringList sites() const;
+
+    // Agrega un nuevo componente a la base de datos (sitio vacío = almacén principal).
+    // En newId deja el ID asignado
     bool addComponent(const QString &name, const QString &type,
                       int quantity, const QString &location,
-                      const QDate &purchaseDate);
+                      const QDate &purchaseDate, const QString &site = QString(),
+                      qint64 *newId = nullptr);
 
     // Actualiza un componente existente por su ID
-    bool actualizarComponente(int id, const QString& nombre, const QString& tipo,
+    bool actualizarComponente(qint64 id, const QString& nombre, const QString& tipo,
                               int cantidad, const QString& ubicacion,
-                              const QDate& fecha);
+                              const QDate& fecha, const QString& sitio = QString());
 
     // Elimina un componente por su ID
-    bool eliminarComponente(const QString &id);
+    bool eliminarComponente(qint64 id, const QString &sitio = QString());
+
+    // Obtiene todos los componentes de todos los almacenes, ordenados por nombre
+    QVector<Component> getAllComponents() const;
+
+    // Componentes cuyo nombre, tipo o ubicación contienen el texto, ordenados por nombre
+    QVector<Component> searchComponents(const QString &texto) const;
+
+    // Componentes comprados entre dos fechas (ambas incluidas), ordenados por fecha
+    QVector<Component> componentsPurchasedBetween(const QDate &desde, const QDate &hasta) const;
+
+    // Igual, pero entrega cada componente en orden al visitante (que devuelve false
+    // para parar) sin construir la lista mezclada. Cada almacén sí lee su parte entera
+    void componentsPurchasedBetween(const QDate &desde, const QDate &hasta,
+                                    const std::function<bool(const Component &)> &visitor) const;
+
+    // Componentes comprados hace más de 'dias' días, del más antiguo al más reciente
+    QVector<Component> componentsOlderThan(int dias) const;
 
-    // Obtiene todos los componentes como una lista de listas de strings
-    QVector<QStringList> getAllComponents() const;
+    // Igual, entregando cada componente al visitante (ver componentsPurchasedBetween)
+    void componentsOlderThan(int dias,
+                             const std::function<bool(const Component &)> &visitor) const;
+
+    // Suma de cantidades por tipo en todos los almacenes
+    QMap<QString, int> cantidadPorTipo() const;
+
+    // Entrega a 'visitor' los cambios posteriores a la última exportación confirmada
+    // del consumidor (se detiene si devuelve false). Un consumidor sin marca en un
+    // almacén recibe su catálogo completo: un cambio "reset" (solo con el sitio) y un
+    // "insert" por componente. En newWatermarks deja la marca que hay que confirmar
+    // en cada almacén cuando el destino esté completo
+    bool readChanges(const QString &consumer,
+                     const std::function<bool(const ComponentChange &)> &visitor,
+                     QVector<qint64> *newWatermarks) const;
+
+    // Confirma las marcas leídas con readChanges y poda el diario de cambios
+    bool commitWatermarks(const QString &consumer, const QVector<qint64> &watermarks);
 
     // Devuelve el último error de la base de datos
     QSqlError lastError() const;
 
+    // Ruta del archivo de la base de datos abierta (para respaldos)
+    QString databasePath() const { return m_db.databaseName(); }
+
+    // Rutas de los archivos de todos los almacenes
+    QStringList databasePaths() const;
+
+    // Posición del almacén en sites() (-1 si no existe)
+    int shardIndex(const QString &site) const;
+
 private:
-    QSqlDatabase m_db;      // Objeto de conexión a la base de datos
+    // Indica si dos bases de datos tienen el mismo nombre de archivo (sin directorio
+    // ni extensión, sin distinguir mayúsculas)
+    static bool mismoNombreDeArchivo(const QString &a, const QString &b);
+
+    // Almacén: sitio y conexión abierta en el hilo principal
+    struct Shard {
+        QString site;
+        QSqlDatabase db;
+    };
+
+    QSqlDatabase m_db;      // Objeto de conexión a la base de datos principal
+    QVector<Shard> m_shards; // Almacenes abiertos (el primero es el principal)
+    QThreadPool *m_pool;     // Hilos para las consultas repartidas entre almacenes
+    int m_instance;          // Número de instancia, distingue sus conexiones
+
+    // Nombre de conexión propio de esta instancia
+    QString connectionName(const QString &base) const;
+
+    // Crea las tablas necesarias si no existen y migra el esquema antiguo
+    bool createTables(QSqlDatabase &db);
+
+    // Migra purchase_date (TEXT ISO) a purchase_day (INTEGER, día juliano)
+    bool migrateToDayNumbers(QSqlQuery &query);
+
+    // Abre una conexión con nombre a un archivo de base de datos
+    bool openShard(const QString &site, const QString &databasePath,
+                   const QString &connectionName);
+
+    // Entrega la instantánea de un almacén a un consumidor nuevo (ver readChanges)
+    bool readSnapshot(const Shard &shard, qint64 hasta,
+                      const std::function<bool(const ComponentChange &)> &visitor) const;
+
+    // Conexión del almacén indicado (sitio vacío = principal)
+    QSqlDatabase shardDb(const QString &site) const;
 
-    // Crea las tablas necesarias si no existen
-    bool createTables();
+    // Ejecuta una consulta de lectura en cada almacén en paralelo y devuelve los
+    // resultados en el orden de sites()
+    template <typename T, typename Fn>
+    QVector<T> fanOut(Fn consulta) const;
 };
 
-#endif // DATABASEMANAGER_H
\ No newline at end of file
+#endif // DATABASEMANAGER_H
@@ -0,0 +1,15 @@
+#ifndef DBERROR_H
+#define DBERROR_H
+
+#include <QDebug>
+#include <QString>
+
+// Registra un error de la capa de datos y, si el llamador lo pidió, se lo devuelve
+// en 'error' (convención de las funciones con parámetro QString *error)
+inline void fijarError(QString *error, const QString &mensaje)
+{
+    qCritical() << mensaje;
+    if (error) *error = mensaje;
+}
+
+#endif // DBERROR_H
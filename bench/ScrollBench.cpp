@@ -0,0 +1,122 @@
+// Benchmark de desplazamiento de la tabla de componentes.
+//
+// Crea una base de datos temporal con N componentes, la muestra en una QTableView
+// (plataforma offscreen) y mide el tiempo de repintado de cada "fotograma",
+// primero con la configuración por defecto de la vista y después con
+// CachedCellDelegate y filas de altura fija. Cada configuración se mide en tres
+// recorridos:
+//  - salto: la tabla completa en 'fotogramas' pasos (casi todas las filas son nuevas)
+//  - rueda: tres filas por fotograma, como la rueda del ratón (casi todas repetidas)
+//  - repintado: la misma posición una y otra vez (todas repetidas)
+//
+// Uso: ScrollBench [filas] [fotogramas]
+
+#include "DataHub/DBControl.h"
+#include "model/CompList.h"
+#include "model/FiltProxy.h"
+#include "model/CellDeleg.h"
+#include "tests/TestUtil.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QHeaderView>
+#include <QScrollBar>
+#include <QTableView>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+
+// Filas que avanza la rueda del ratón en cada paso
+static const int FILAS_RUEDA = 3;
+
+// Recorre la tabla avanzando 'paso' unidades de la barra por fotograma (0 = quieta) y
+// devuelve el tiempo de cada repintado en microsegundos
+static QVector<qint64> medir(QTableView &vista, int fotogramas, int paso)
+{
+    QScrollBar *barra = vista.verticalScrollBar();
+
+    // Un repintado previo para que ambas configuraciones partan del mismo estado
+    barra->setValue(0);
+    vista.viewport()->repaint();
+
+    QVector<qint64> tiempos;
+    tiempos.reserve(fotogramas);
+    QElapsedTimer reloj;
+    for (int i = 0; i < fotogramas; ++i) {
+        reloj.start();
+        barra->setValue((i * paso) % (barra->maximum() + 1));
+        vista.viewport()->repaint();
+        tiempos.append(reloj.nsecsElapsed() / 1000);
+    }
+    return tiempos;
+}
+
+// Imprime el resumen de un recorrido
+static void informar(QTextStream &out, const QString &nombre, QVector<qint64> tiempos)
+{
+    std::sort(tiempos.begin(), tiempos.end());
+    out << "  " << nombre << ": p50 " << percentil(tiempos, 0.50) << " ms, p95 "
+        << percentil(tiempos, 0.95) << " ms, máx " << percentil(tiempos, 1.0) << " ms\n";
+}
+
+// Mide e informa los tres recorridos de una vista
+static void medirRecorridos(QTextStream &out, QTableView &vista, int fotogramas)
+{
+    // Pasos en unidades de la barra (filas, o píxeles si la vista se desplaza por píxel)
+    const QScrollBar *barra = vista.verticalScrollBar();
+    const int salto = qMax(1, barra->maximum() / qMax(1, fotogramas));
+    informar(out, "salto", medir(vista, fotogramas, salto));
+    informar(out, "rueda", medir(vista, fotogramas, FILAS_RUEDA * barra->singleStep()));
+    informar(out, "repintado", medir(vista, fotogramas, 0));
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const int filas = argc > 1 ? QString(argv[1]).toInt() : 200000;
+    const int fotogramas = argc > 2 ? QString(argv[2]).toInt() : 500;
+
+    QTemporaryDir dir;
+    const QString ruta = dir.filePath("inventario.db");
+
+    DatabaseManager db;
+    if (!db.initialize(ruta) || !poblarComponentes(ruta, filas)) {
+        out << "No se pudo preparar la base de datos\n";
+        return 1;
+    }
+
+    QElapsedTimer reloj;
+    reloj.start();
+    ComponentModel modelo(&db);
+    out << "Carga de " << modelo.rowCount() << " filas: " << reloj.elapsed() << " ms\n";
+
+    CustomFilterProxyModel proxy;
+    proxy.setSourceModel(&modelo);
+
+    // Configuración anterior: delegado por defecto
+    QTableView porDefecto;
+    porDefecto.setModel(&proxy);
+    porDefecto.horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    porDefecto.resize(1024, 768);
+    porDefecto.show();
+    out << "Delegado por defecto\n";
+    medirRecorridos(out, porDefecto, fotogramas);
+    porDefecto.hide();
+
+    // Configuración nueva: delegado con caché y filas de altura fija
+    QTableView conCache;
+    conCache.setModel(&proxy);
+    conCache.horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    CachedCellDelegate::configurarVista(&conCache);
+    conCache.resize(1024, 768);
+    conCache.show();
+    out << "Delegado con caché\n";
+    medirRecorridos(out, conCache, fotogramas);
+
+    return 0;
+}
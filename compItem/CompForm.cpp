@@ -8,7 +8,9 @@ ComponentDialog::ComponentDialog(QWidget *parent,
                                  const QString& tipo,
                                  int cantidad,
                                  const QString& ubicacion,
-                                 const QDate& fecha)
+                                 const QDate& fecha,
+                                 const QStringList& sitios,
+                                 const QString& sitio)
     : QDialog(parent), ui(new Ui::ComponentDialog)
 {
     ui->setupUi(this); // Inicializa la interfaz gráfica generada por Qt Designer
@@ -26,6 +28,12 @@ ComponentDialog::ComponentDialog(QWidget *parent,
     ui->lineEditUbicacion->setText(ubicacion);     // Ubicación
     ui->dateEdit->setDate(fecha);                  // Fecha de adquisición
 
+    // El almacén solo se elige cuando hay más de uno
+    ui->comboSitio->addItems(sitios);
+    if (!sitio.isEmpty()) ui->comboSitio->setCurrentText(sitio);
+    ui->labelSitio->setVisible(sitios.size() > 1);
+    ui->comboSitio->setVisible(sitios.size() > 1);
+
     // Título dinámico según el modo (añadir o editar)
     setWindowTitle(nombre.isEmpty() ? "Añadir Componente" : "Editar Componente");
 }
@@ -61,4 +69,9 @@ QString ComponentDialog::ubicacion() const {
 // Devuelve la fecha de adquisición seleccionada
 QDate ComponentDialog::fechaAdquisicion() const {
     return ui->dateEdit->date();
+}
+
+// Devuelve el almacén seleccionado (vacío = almacén principal)
+QString ComponentDialog::sitio() const {
+    return ui->comboSitio->currentText();
 }
\ No newline at end of file
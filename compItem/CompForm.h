@@ -3,6 +3,7 @@
 
 #include <QDialog>
 #include <QDate>
+#include <QStringList>
 
 // Espacio de nombres generado por Qt Designer para la UI
 namespace Ui {
@@ -22,7 +23,9 @@ public:
                              const QString& tipo = "",
                              int cantidad = 1,
                              const QString& ubicacion = "",
-                             const QDate& fecha = QDate::currentDate());
+                             const QDate& fecha = QDate::currentDate(),
+                             const QStringList& sitios = QStringList(),
+                             const QString& sitio = "");
     // Destructor
     ~ComponentDialog();
 
@@ -32,6 +35,7 @@ public:
     int cantidad() const;             // Devuelve la cantidad
     QString ubicacion() const;        // Devuelve la ubicación
     QDate fechaAdquisicion() const;   // Devuelve la fecha de adquisición
+    QString sitio() const;            // Devuelve el almacén seleccionado
 
 private:
     Ui::ComponentDialog *ui; // Puntero a la interfaz gráfica generada por Qt Designer
@@ -1,8 +1,178 @@
 #include "panel.h"
+#include "DataHub/DBBackup.h"
+#include "DataHub/ChangeExport.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QTextStream>
+
+// Escribe la línea de un componente (búsqueda e informes de antigüedad y de compras)
+static bool listarComponente(QTextStream &out, const Component &c)
+{
+    out << c.purchaseDate.toString(Qt::ISODate) << '\t' << c.site << '\t' << c.id << '\t'
+        << c.name << '\t' << c.type << '\t' << c.quantity << '\t' << c.location << '\n';
+    return true;
+}
+
+// Escribe una línea por componente
+static void listarComponentes(QTextStream &out, const QVector<Component> &componentes)
+{
+    for (const Component &c : componentes) listarComponente(out, c);
+}
+
+// Modo consola: respaldo, verificación, restauración, exportación de cambios,
+// búsqueda e informes por fecha de compra sin abrir la ventana
+static int ejecutarConsola(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Inventario: respaldo, restauración y exportación de cambios");
+    parser.addHelpOption();
+
+    QCommandLineOption optDb("db", "Ruta de la base de datos.", "ruta",
+                             QDir::current().absoluteFilePath("inventario.db"));
+    QCommandLineOption optRespaldo("respaldo",
+                                   "Respalda todos los almacenes en el directorio indicado.",
+                                   "directorio");
+    QCommandLineOption optCada("cada", "Con --respaldo, lo repite cada N minutos.", "minutos");
+    QCommandLineOption optVerificar("verificar", "Comprueba un archivo de respaldo.", "archivo");
+    QCommandLineOption optRestaurar("restaurar",
+                                    "Restaura el almacén del respaldo indicado (se puede repetir).",
+                                    "archivo");
+    QCommandLineOption optCambios("exportar-cambios",
+                                  "Exporta los cambios desde la última exportación (.jsonl o .csv).",
+                                  "archivo");
+    QCommandLineOption optConsumidor("consumidor", "Consumidor de la exportación de cambios.",
+                                     "nombre", "erp");
+    QCommandLineOption optBuscar("buscar",
+                                 "Lista los componentes cuyo nombre, tipo o ubicación contienen el texto.",
+                                 "texto");
+    QCommandLineOption optAntiguedad("antiguedad",
+                                     "Lista los componentes comprados hace más de N días.", "dias");
+    QCommandLineOption optDesde("compras-desde", "Lista las compras desde la fecha (AAAA-MM-DD).",
+                                "fecha");
+    QCommandLineOption optHasta("compras-hasta", "Con --compras-desde, fecha final (por defecto hoy).",
+                                "fecha");
+    parser.addOptions({optDb, optRespaldo, optCada, optVerificar, optRestaurar,
+                       optCambios, optConsumidor, optBuscar, optAntiguedad, optDesde, optHasta});
+    parser.process(app);
+
+    const QString dbPath = parser.value(optDb);
+    const QStringList rutasAlmacenes = DatabaseManager::configuredDatabasePaths(dbPath);
+    QString error;
+
+    if (parser.isSet(optVerificar)) {
+        if (!BackupManager::verificar(parser.value(optVerificar), &error)) return 1;
+        out << "Respaldo correcto\n";
+        return 0;
+    }
+
+    // Cada respaldo se restaura sobre el almacén del que se hizo
+    if (parser.isSet(optRestaurar)) {
+        for (const QString &archivo : parser.values(optRestaurar)) {
+            QString destino;
+            for (const QString &ruta : rutasAlmacenes) {
+                if (BackupManager::esRespaldoDe(archivo, ruta)) destino = ruta;
+            }
+            if (destino.isEmpty()) {
+                out << "El respaldo no corresponde a ningún almacén: " << archivo << "\n";
+                return 1;
+            }
+            if (!BackupManager::restaurar(archivo, destino, &error)) return 1;
+            out << "Base de datos restaurada en " << destino << "\n";
+        }
+        return 0;
+    }
+
+    if (parser.isSet(optCambios)) {
+        DatabaseManager db;
+        if (!db.initializeFromConfig(dbPath)) return 1;
+
+        const QString archivo = parser.value(optCambios);
+        int filas = 0;
+        if (!ChangeExporter::exportar(db, archivo, ChangeExporter::formatoPorExtension(archivo),
+                                      parser.value(optConsumidor), &filas, &error)) {
+            return 1;
+        }
+        out << "Cambios exportados: " << filas << "\n";
+        return 0;
+    }
+
+    if (parser.isSet(optBuscar) || parser.isSet(optAntiguedad) || parser.isSet(optDesde)) {
+        bool diasOk = true;
+        const int dias =
+            parser.isSet(optAntiguedad) ? parser.value(optAntiguedad).toInt(&diasOk) : 0;
+        if (!diasOk || dias < 0) {
+            out << "Número de días no válido: " << parser.value(optAntiguedad) << "\n";
+            return 1;
+        }
+
+        // Los informes por fecha se escriben fila a fila, sin construir la lista completa
+        auto listar = [&out](const Component &c) { return listarComponente(out, c); };
+
+        DatabaseManager db;
+        if (!db.initializeFromConfig(dbPath)) return 1;
+
+        if (parser.isSet(optBuscar)) {
+            listarComponentes(out, db.searchComponents(parser.value(optBuscar)));
+            return 0;
+        }
+
+        if (parser.isSet(optAntiguedad)) {
+            db.componentsOlderThan(dias, listar);
+            return 0;
+        }
+
+        const QDate desde = QDate::fromString(parser.value(optDesde), Qt::ISODate);
+        const QDate hasta = parser.isSet(optHasta)
+                                ? QDate::fromString(parser.value(optHasta), Qt::ISODate)
+                                : QDate::currentDate();
+        if (!desde.isValid() || !hasta.isValid()) {
+            out << "Fecha no válida (formato AAAA-MM-DD)\n";
+            return 1;
+        }
+        db.componentsPurchasedBetween(desde, hasta, listar);
+        return 0;
+    }
+
+    if (parser.isSet(optRespaldo)) {
+        const QString dir = parser.value(optRespaldo);
+        const int minutos = parser.value(optCada).toInt();
+
+        // Respaldo único de cada almacén
+        if (minutos <= 0) {
+            for (const QString &ruta : rutasAlmacenes) {
+                const QString archivo = BackupManager::crearRespaldo(ruta, dir, &error);
+                if (archivo.isEmpty()) return 1;
+                out << "Respaldo creado: " << archivo << "\n";
+            }
+            return 0;
+        }
+
+        // Respaldo programado: se ejecuta hasta que se detenga el proceso
+        BackupManager gestor;
+        QObject::connect(&gestor, &BackupManager::respaldoTerminado,
+                         [&out](bool ok, const QString &archivoOError) {
+                             out << (ok ? "Respaldo creado: " : "Error: ") << archivoOError << "\n";
+                             out.flush();
+                         });
+        gestor.programar(rutasAlmacenes, dir, minutos);
+        gestor.respaldarEnSegundoPlano(rutasAlmacenes, dir);
+        return app.exec();
+    }
+
+    parser.showHelp(1);
+}
 
 int main(int argc, char *argv[])
 {
+    // Cualquier opción "--..." ejecuta el modo consola
+    for (int i = 1; i < argc; ++i) {
+        if (QByteArray(argv[i]).startsWith("--")) return ejecutarConsola(argc, argv);
+    }
+
     QApplication a(argc, argv);
     Inventario w;
     w.show();
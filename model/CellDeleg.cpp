@@ -0,0 +1,151 @@
+#include "CellDeleg.h"
+#include <QAbstractProxyModel>
+#include <QHeaderView>
+#include <QLocale>
+#include <QPainter>
+#include <QTableView>
+
+// Margen horizontal del texto dentro de la celda
+static const int MARGEN_TEXTO = 4;
+
+// Espacio vertical añadido a la altura de la fuente en cada fila
+static const int ALTO_EXTRA_FILA = 6;
+
+// Filas que guarda la caché: varias pantallas completas, para que desplazarse
+// cerca de la zona visible no vuelva a consultar el modelo
+static const int MAX_FILAS_CACHE = 1000;
+
+// Constructor: se suscribe a las señales del modelo de origen
+CachedCellDelegate::CachedCellDelegate(QAbstractItemModel *sourceModel, QObject *parent)
+    : QStyledItemDelegate(parent), m_source(sourceModel), m_filas(MAX_FILAS_CACHE)
+{
+    connect(m_source, &QAbstractItemModel::dataChanged,
+            this, &CachedCellDelegate::invalidarFilas);
+
+    // Cualquier cambio de estructura desplaza las filas: se vacía la caché
+    connect(m_source, &QAbstractItemModel::modelReset, this, &CachedCellDelegate::invalidarTodo);
+    connect(m_source, &QAbstractItemModel::layoutChanged, this, &CachedCellDelegate::invalidarTodo);
+    connect(m_source, &QAbstractItemModel::rowsInserted, this, &CachedCellDelegate::invalidarTodo);
+    connect(m_source, &QAbstractItemModel::rowsRemoved, this, &CachedCellDelegate::invalidarTodo);
+    connect(m_source, &QAbstractItemModel::rowsMoved, this, &CachedCellDelegate::invalidarTodo);
+    connect(m_source, &QAbstractItemModel::columnsInserted, this, &CachedCellDelegate::invalidarTodo);
+    connect(m_source, &QAbstractItemModel::columnsRemoved, this, &CachedCellDelegate::invalidarTodo);
+}
+
+// Instala el delegado en la vista y fija la geometría de las filas: todas tienen
+// la misma altura, por lo que la vista no necesita medir ninguna fila
+CachedCellDelegate *CachedCellDelegate::configurarVista(QTableView *vista)
+{
+    QAbstractItemModel *modelo = vista->model();
+    if (auto *proxy = qobject_cast<QAbstractProxyModel *>(modelo)) {
+        modelo = proxy->sourceModel();
+    }
+
+    auto *delegado = new CachedCellDelegate(modelo, vista);
+    vista->setItemDelegate(delegado);
+    vista->setWordWrap(false);
+    vista->setTextElideMode(Qt::ElideRight);
+
+    QHeaderView *filas = vista->verticalHeader();
+    filas->setSectionResizeMode(QHeaderView::Fixed);
+    filas->setDefaultSectionSize(vista->fontMetrics().height() + ALTO_EXTRA_FILA);
+    filas->setMinimumSectionSize(vista->fontMetrics().height() + ALTO_EXTRA_FILA);
+
+    return delegado;
+}
+
+// Índice del modelo de origen correspondiente a un índice de la vista
+QModelIndex CachedCellDelegate::aOrigen(const QModelIndex &index) const
+{
+    if (auto *proxy = qobject_cast<const QAbstractProxyModel *>(index.model())) {
+        return proxy->mapToSource(index);
+    }
+    return index;
+}
+
+// Fila en caché, rellenándola desde el modelo si hace falta. Insertar una fila
+// nueva descarta la usada hace más tiempo; la referencia devuelta es válida
+// hasta la siguiente llamada
+CachedCellDelegate::Fila &CachedCellDelegate::fila(int sourceRow) const
+{
+    if (Fila *f = m_filas.object(sourceRow)) {
+        return *f;
+    }
+
+    auto *f = new Fila;
+    const int columnas = m_source->columnCount();
+    f->celdas.resize(columnas);
+    for (int col = 0; col < columnas; ++col) {
+        const QModelIndex idx = m_source->index(sourceRow, col);
+        Celda &celda = f->celdas[col];
+        // Mismo formato que el delegado por defecto (fechas y números según la locale)
+        celda.texto = displayText(m_source->data(idx, Qt::DisplayRole), QLocale());
+        celda.fondo = qvariant_cast<QBrush>(m_source->data(idx, Qt::BackgroundRole));
+    }
+    m_filas.insert(sourceRow, f);
+    return *f;
+}
+
+// Dibuja la celda con los datos de la caché
+void CachedCellDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                               const QModelIndex &index) const
+{
+    const QModelIndex origen = aOrigen(index);
+    if (!origen.isValid() || origen.row() >= m_source->rowCount()) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    Celda &celda = fila(origen.row()).celdas[origen.column()];
+
+    // El texto recortado solo se recalcula cuando cambia el ancho de la columna
+    const QRect area = option.rect.adjusted(MARGEN_TEXTO, 0, -MARGEN_TEXTO, 0);
+    if (celda.ancho != area.width()) {
+        celda.elidido = option.fontMetrics.elidedText(celda.texto, Qt::ElideRight, area.width());
+        celda.ancho = area.width();
+    }
+
+    const bool seleccionada = option.state.testFlag(QStyle::State_Selected);
+    if (seleccionada) {
+        painter->fillRect(option.rect, option.palette.highlight());
+    } else if (celda.fondo.style() != Qt::NoBrush) {
+        painter->fillRect(option.rect, celda.fondo);
+    }
+
+    const QPen lapizAnterior = painter->pen();
+    painter->setPen(option.palette.color(seleccionada ? QPalette::HighlightedText
+                                                      : QPalette::Text));
+    painter->drawText(area, Qt::AlignLeft | Qt::AlignVCenter, celda.elidido);
+    painter->setPen(lapizAnterior);
+}
+
+// Tamaño de la celda a partir del texto en caché (sin consultar al modelo)
+QSize CachedCellDelegate::sizeHint(const QStyleOptionViewItem &option,
+                                   const QModelIndex &index) const
+{
+    const QModelIndex origen = aOrigen(index);
+    if (!origen.isValid() || origen.row() >= m_source->rowCount()) {
+        return QStyledItemDelegate::sizeHint(option, index);
+    }
+
+    const QString &texto = fila(origen.row()).celdas[origen.column()].texto;
+    return QSize(option.fontMetrics.horizontalAdvance(texto) + 2 * MARGEN_TEXTO,
+                 option.fontMetrics.height() + ALTO_EXTRA_FILA);
+}
+
+// Invalida las filas afectadas por dataChanged
+void CachedCellDelegate::invalidarFilas(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    // Se recorren las filas en caché (como mucho MAX_FILAS_CACHE), no el rango
+    for (int row : m_filas.keys()) {
+        if (row >= topLeft.row() && row <= bottomRight.row()) {
+            m_filas.remove(row);
+        }
+    }
+}
+
+// Vacía la caché cuando cambia la estructura del modelo
+void CachedCellDelegate::invalidarTodo()
+{
+    m_filas.clear();
+}
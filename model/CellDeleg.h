@@ -0,0 +1,66 @@
+#ifndef CACHEDCELLDELEGATE_H
+#define CACHEDCELLDELEGATE_H
+
+#include <QStyledItemDelegate>
+#include <QBrush>
+#include <QCache>
+#include <QVector>
+
+class QTableView;
+
+// Delegado de celdas con caché para tablas grandes.
+// Guarda por fila del modelo de origen el texto y el fondo de cada celda, y el
+// texto recortado (elided) para el ancho actual de la columna. Así cada repintado
+// solo dibuja: el modelo se consulta una vez por fila hasta que dataChanged la
+// invalida. Solo se guardan las filas usadas más recientemente (las que rodean
+// la zona visible), así que la memoria no crece con el tamaño del modelo.
+class CachedCellDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    // Constructor: recibe el modelo de origen (no el proxy) cuyas señales invalidan la caché
+    explicit CachedCellDelegate(QAbstractItemModel *sourceModel, QObject *parent = nullptr);
+
+    // Dibuja la celda con los datos de la caché
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+               const QModelIndex &index) const override;
+
+    // Tamaño de la celda a partir del texto en caché
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    // Instala el delegado en la vista y fija la geometría de las filas
+    static CachedCellDelegate *configurarVista(QTableView *vista);
+
+private slots:
+    // Invalida las filas afectadas por dataChanged
+    void invalidarFilas(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+    // Vacía la caché cuando cambia la estructura del modelo
+    void invalidarTodo();
+
+private:
+    // Datos precalculados de una celda
+    struct Celda {
+        QString texto;     // Texto completo (DisplayRole)
+        QString elidido;   // Texto recortado para 'ancho'
+        int ancho = -1;    // Ancho para el que se calculó 'elidido'
+        QBrush fondo;      // Fondo (BackgroundRole)
+    };
+
+    // Celdas de una fila del modelo de origen
+    struct Fila {
+        QVector<Celda> celdas;
+    };
+
+    // Fila en caché, rellenándola desde el modelo si hace falta
+    Fila &fila(int sourceRow) const;
+
+    // Índice del modelo de origen correspondiente a un índice de la vista
+    QModelIndex aOrigen(const QModelIndex &index) const;
+
+    QAbstractItemModel *m_source;       // Modelo de origen
+    mutable QCache<int, Fila> m_filas;  // Caché LRU por fila de origen
+};
+
+#endif // CACHEDCELLDELEGATE_H
@@ -1,5 +1,9 @@
 #include "CompList.h"
 #include <QColor>
+#include <algorithm>
+
+// Cantidad por debajo de la cual se resalta el stock
+static const int STOCK_BAJO = 5;
 
 // Constructor del modelo, recibe el gestor de base de datos y el padre opcional
 ComponentModel::ComponentModel(DatabaseManager* dbManager, QObject* parent)
@@ -15,22 +19,36 @@ int ComponentModel::rowCount(const QModelIndex&) const {
 
 // Devuelve el número de columnas (campos por componente)
 int ComponentModel::columnCount(const QModelIndex&) const {
-    return 6; // ID, Nombre, Tipo, Cantidad, Ubicación, Fecha
+    return 7; // ID, Nombre, Tipo, Cantidad, Ubicación, Fecha, Sitio
 }
 
 // Devuelve los datos para una celda específica, según el rol solicitado
 QVariant ComponentModel::data(const QModelIndex& index, int role) const {
     if (!index.isValid()) return QVariant(); // Si el índice no es válido, retorna vacío
 
-    // Muestra el dato para la celda (modo visualización o edición)
+    const Component& componente = m_components[index.row()];
+
+    // Muestra el dato para la celda con su tipo (la vista ordena y formatea según él)
     if (role == Qt::DisplayRole || role == Qt::EditRole) {
-        return m_components[index.row()][index.column()];
+        switch (index.column()) {
+        case 0: return componente.id;
+        case 1: return componente.name;
+        case 2: return componente.type;
+        case 3: return componente.quantity;
+        case 4: return componente.location;
+        case 5: return componente.purchaseDate;
+        case 6: return componente.site;
+        }
     }
 
-    // Resalta en rojo la celda de cantidad si el stock es bajo (<5)
+    // Clave estable de la fila, usada por el proxy en la búsqueda difusa
+    if (role == KeyRole) {
+        return claveFila(componente);
+    }
+
+    // Resalta en rojo la celda de cantidad si el stock es bajo
     if (role == Qt::BackgroundRole && index.column() == 3) { // Columna de cantidad
-        int cantidad = m_components[index.row()][3].toInt();
-        if (cantidad < 5) return QColor(Qt::red);
+        if (componente.quantity < STOCK_BAJO) return QColor(Qt::red);
     }
 
     return QVariant(); // Para otros roles, retorna vacío
@@ -39,7 +57,7 @@ QVariant ComponentModel::data(const QModelIndex& index, int role) const {
 // Devuelve los encabezados de columna para la vista de tabla
 QVariant ComponentModel::headerData(int section, Qt::Orientation orientation, int role) const {
     if (role == Qt::DisplayRole && orientation == Qt::Horizontal) {
-        static QStringList headers = {"ID", "Nombre", "Tipo", "Cantidad", "Ubicación", "Fecha"};
+        static QStringList headers = {"ID", "Nombre", "Tipo", "Cantidad", "Ubicación", "Fecha", "Sitio"};
         return headers[section];
     }
     return QVariant();
@@ -50,9 +68,102 @@ void ComponentModel::refresh()
 {
     beginResetModel(); // Notifica a la vista que el modelo va a cambiar
     m_components = m_dbManager->getAllComponents(); // Obtiene los datos actualizados
+    reconstruirIndice(); // Mantiene el índice de búsqueda al día tras cada cambio
     endResetModel(); // Notifica que el cambio terminó
 
     // Opcional: emitir señal de datos cambiados para actualizar la vista
     emit dataChanged(createIndex(0, 0),
                      createIndex(rowCount()-1, columnCount()-1));
-}
\ No newline at end of file
+}
+
+// Inserta un componente nuevo en su posición y en el índice de búsqueda. El índice
+// se actualiza antes de endInsertRows: rowsInserted repite la búsqueda difusa
+void ComponentModel::componenteAnadido(const Component& componente)
+{
+    const int row = filaPorNombre(componente.name);
+    beginInsertRows(QModelIndex(), row, row);
+    m_components.insert(row, componente);
+    m_index.insert(claveFila(componente), textoIndexable(componente));
+    endInsertRows();
+}
+
+// Reemplaza los datos de un componente; si cambia de nombre se mueve su fila
+void ComponentModel::componenteActualizado(const Component& componente)
+{
+    const int row = filaDe(componente.id, componente.site);
+    if (row < 0) {
+        componenteAnadido(componente);
+        return;
+    }
+
+    m_components[row] = componente;
+    m_index.insert(claveFila(componente), textoIndexable(componente)); // Reemplaza la entrada
+
+    const bool enOrden = (row == 0 || !(componente.name < m_components[row - 1].name))
+        && (row + 1 == m_components.size() || !(m_components[row + 1].name < componente.name));
+    int destino = row;
+    if (!enOrden) {
+        // Posición entre las demás filas; beginMoveRows la cuenta antes de quitar la fila
+        m_components.remove(row);
+        destino = filaPorNombre(componente.name);
+        m_components.insert(row, componente);
+
+        beginMoveRows(QModelIndex(), row, row, QModelIndex(), destino >= row ? destino + 1 : destino);
+        m_components.move(row, destino);
+        endMoveRows();
+    }
+    emit dataChanged(index(destino, 0), index(destino, columnCount() - 1));
+}
+
+// Quita un componente eliminado del modelo y del índice de búsqueda
+void ComponentModel::componenteEliminado(qint64 id, const QString& sitio)
+{
+    const int row = filaDe(id, sitio);
+    if (row < 0) return;
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_index.remove(claveFila(m_components[row]));
+    m_components.remove(row);
+    endRemoveRows();
+}
+
+// Fila de un componente (-1 si no está cargado)
+int ComponentModel::filaDe(qint64 id, const QString& sitio) const
+{
+    for (int row = 0; row < m_components.size(); ++row) {
+        if (m_components[row].id == id && m_components[row].site == sitio) return row;
+    }
+    return -1;
+}
+
+// Primera fila cuyo nombre va después del dado (las filas están ordenadas por nombre)
+int ComponentModel::filaPorNombre(const QString& nombre) const
+{
+    const auto it = std::upper_bound(m_components.begin(), m_components.end(), nombre,
+                                     [](const QString& n, const Component& c) { return n < c.name; });
+    return int(it - m_components.begin());
+}
+
+// Texto que se indexa para la búsqueda difusa: nombre, tipo y ubicación
+QString ComponentModel::textoIndexable(const Component& componente)
+{
+    return componente.name + ' ' + componente.type + ' ' + componente.location;
+}
+
+// Clave única de una fila: los IDs se repiten entre almacenes, así que se
+// combinan con la posición del almacén
+qint64 ComponentModel::claveFila(const Component& componente) const
+{
+    const qint64 almacen = m_dbManager->shardIndex(componente.site);
+    return (almacen << 32) | componente.id;
+}
+
+// Reconstruye el índice de trigramas a partir de los datos cargados
+void ComponentModel::reconstruirIndice()
+{
+    m_index.clear();
+    m_index.reserve(m_components.size());
+    for (const Component& componente : m_components) {
+        m_index.insert(claveFila(componente), textoIndexable(componente));
+    }
+}
@@ -4,6 +4,7 @@
 #include <QAbstractTableModel>
 #include <QVector>
 #include "../DataHub/DBControl.h"
+#include "TrigramIdx.h"
 
 // Modelo de tabla para representar los componentes en la vista
 class ComponentModel : public QAbstractTableModel
@@ -11,6 +12,11 @@ class ComponentModel : public QAbstractTableModel
     Q_OBJECT
 
 public:
+    // Roles propios del modelo
+    enum Roles {
+        KeyRole = Qt::UserRole + 1 // Clave estable de la fila (almacén e ID del componente)
+    };
+
     // Constructor: recibe el gestor de base de datos y el padre opcional
     explicit ComponentModel(DatabaseManager* dbManager, QObject* parent = nullptr);
 
@@ -28,19 +34,45 @@ public:
     // Devuelve los encabezados de columna o fila
     QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
 
-    // Devuelve los datos de un componente específico (por fila)
-    QStringList getComponentData(int row) const {
-        if (row >= 0 && row < m_components.size())
-            return m_components[row];
-        return QStringList();
+    // Devuelve el componente de una fila (la fila debe ser válida)
+    const Component& component(int row) const {
+        return m_components[row];
     }
 
-    // Recarga los datos desde la base de datos
+    // Recarga los datos desde la base de datos y reconstruye el índice de búsqueda
     void refresh();
 
+    // Actualizaciones de una sola fila tras guardar el cambio en la base de datos.
+    // Mantienen el orden por nombre y actualizan solo esa fila en el índice.
+    void componenteAnadido(const Component& componente);
+    void componenteActualizado(const Component& componente);
+    void componenteEliminado(qint64 id, const QString& sitio);
+
+    // Búsqueda tolerante a errores sobre nombre, tipo y ubicación.
+    // Devuelve las claves (KeyRole) de las filas más parecidas, de mayor a menor similitud.
+    QVector<TrigramIndex::Hit> buscarDifuso(const QString& consulta, int maxResultados) const {
+        return m_index.search(consulta, maxResultados);
+    }
+
 private:
+    // Texto que se indexa para la búsqueda difusa de una fila
+    static QString textoIndexable(const Component& componente);
+
+    // Clave única de una fila (KeyRole)
+    qint64 claveFila(const Component& componente) const;
+
+    // Reconstruye el índice de trigramas a partir de m_components
+    void reconstruirIndice();
+
+    // Fila de un componente (-1 si no está cargado)
+    int filaDe(qint64 id, const QString& sitio) const;
+
+    // Fila en la que hay que insertar un nombre para mantener el orden
+    int filaPorNombre(const QString& nombre) const;
+
     DatabaseManager* m_dbManager;         // Puntero al gestor de base de datos
-    QVector<QStringList> m_components;    // Almacena los datos de los componentes
+    QVector<Component> m_components;      // Almacena los datos de los componentes
+    TrigramIndex m_index;                 // Índice de trigramas para la búsqueda difusa
 };
 
 #endif // COMPONENTMODEL_H
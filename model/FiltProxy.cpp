@@ -1,4 +1,5 @@
 #include "FiltProxy.h"
+#include "CompList.h"
 #include <QModelIndex>
 
 // Constructor: inicializa el proxy model, llama al constructor base
@@ -13,8 +14,12 @@ bool CustomFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &
     QModelIndex typeIndex = sourceModel()->index(sourceRow, 2, sourceParent); // Columna de tipo
     QString type = sourceModel()->data(typeIndex).toString();
 
+    // En modo difuso solo pasan las filas devueltas por el índice de trigramas
+    if (m_modoDifuso) {
+        if (similitud(sourceRow, sourceParent) < 0) return false;
+    }
     // Si hay un filtro de texto activo (búsqueda)
-    if (!filterRegularExpression().pattern().isEmpty()) {
+    else if (!filterRegularExpression().pattern().isEmpty()) {
         bool matchesSearch = false;
         // Recorre todas las columnas de la fila
         for (int col = 0; col < sourceModel()->columnCount(); ++col) {
@@ -36,4 +41,51 @@ bool CustomFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &
 
     // Si pasa todos los filtros, acepta la fila
     return true;
-}
\ No newline at end of file
+}
+
+// Filtra por tipo (vacío = todos). Es independiente de la búsqueda por texto,
+// así que funciona tanto con la expresión regular como en modo difuso
+void CustomFilterProxyModel::setFilterTipo(const QString &tipo)
+{
+    if (m_filterTipo == tipo) return;
+    m_filterTipo = tipo;
+    invalidateFilter();
+}
+
+// Activa el modo difuso con los resultados de ComponentModel::buscarDifuso
+void CustomFilterProxyModel::setResultadosDifusos(const QVector<TrigramIndex::Hit> &resultados)
+{
+    m_similitudes.clear();
+    m_similitudes.reserve(resultados.size());
+    for (const TrigramIndex::Hit &hit : resultados) {
+        m_similitudes.insert(hit.key, hit.score);
+    }
+    m_modoDifuso = true;
+    invalidate(); // Vuelve a filtrar y ordenar con los nuevos resultados
+}
+
+// Vuelve al modo de búsqueda por expresión regular
+void CustomFilterProxyModel::limpiarResultadosDifusos()
+{
+    if (!m_modoDifuso) return;
+    m_modoDifuso = false;
+    m_similitudes.clear();
+    invalidate();
+}
+
+// Similitud de la fila de origen en la última búsqueda difusa (-1 si no aparece)
+float CustomFilterProxyModel::similitud(int sourceRow, const QModelIndex &sourceParent) const
+{
+    QModelIndex idx = sourceModel()->index(sourceRow, 0, sourceParent);
+    qint64 clave = sourceModel()->data(idx, ComponentModel::KeyRole).toLongLong();
+    return m_similitudes.value(clave, -1.0f);
+}
+
+// En modo difuso las filas más parecidas van primero, sea cual sea la columna
+bool CustomFilterProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    if (m_modoDifuso) {
+        return similitud(left.row(), left.parent()) > similitud(right.row(), right.parent());
+    }
+    return QSortFilterProxyModel::lessThan(left, right);
+}
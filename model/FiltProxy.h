@@ -3,6 +3,8 @@
 
 #include <QSortFilterProxyModel>
 #include <QString>
+#include <QHash>
+#include "TrigramIdx.h"
 
 // Clase proxy personalizada para filtrar la tabla por texto y por tipo
 class CustomFilterProxyModel : public QSortFilterProxyModel
@@ -16,12 +18,29 @@ public:
     // Método para establecer el filtro por tipo (por ejemplo: "Electrónico")
     void setFilterTipo(const QString &tipo);
 
+    // Activa el modo difuso: solo se muestran las filas encontradas, ordenadas por similitud
+    void setResultadosDifusos(const QVector<TrigramIndex::Hit> &resultados);
+
+    // Vuelve al modo de búsqueda por expresión regular
+    void limpiarResultadosDifusos();
+
+    // Indica si el modo difuso está activo
+    bool modoDifuso() const { return m_modoDifuso; }
+
 protected:
     // Método principal de filtrado: decide si una fila debe mostrarse o no
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
 
+    // En modo difuso ordena por similitud; en otro caso usa el orden de la columna
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+
 private:
+    // Similitud de la fila de origen en la última búsqueda difusa (-1 si no aparece)
+    float similitud(int sourceRow, const QModelIndex &sourceParent) const;
+
     QString m_filterTipo; // Almacena el tipo de filtro activo (vacío = sin filtro)
+    bool m_modoDifuso = false;            // true si se filtra por resultados difusos
+    QHash<qint64, float> m_similitudes;   // Clave de la fila -> similitud
 };
 
 #endif // CUSTOMFILTERPROXYMODEL_H
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "TrigramIdx.h"
+#include <QChar>
+#include <algorithm>
+
+// Empaqueta tres caracteres UTF-16 en un único entero de 64 bits
+static inline quint64 empaquetar(ushort a, ushort b, ushort c)
+{
+    return (quint64(a) << 32) | (quint64(b) << 16) | quint64(c);
+}
+
+// Elimina todos los documentos del índice
+void TrigramIndex::clear()
+{
+    m_docs.clear();
+    m_slotPorClave.clear();
+    m_publicaciones.clear();
+    m_eliminados = 0;
+    m_coincidencias.clear();
+    m_tocados.clear();
+}
+
+// Reserva espacio para el número de documentos esperado
+void TrigramIndex::reserve(int documentos)
+{
+    m_docs.reserve(documentos);
+    m_slotPorClave.reserve(documentos);
+}
+
+// Extrae los trigramas distintos de un texto. Cada palabra se rellena como
+// "  palabra " (igual que pg_trgm), se pasa a minúsculas y se quitan los acentos,
+// de modo que "Resistencia" y "resisténcia" comparten todos sus trigramas.
+QVector<quint64> TrigramIndex::trigramasDe(const QString &texto)
+{
+    const QString descompuesto = texto.normalized(QString::NormalizationForm_D);
+    QVector<quint64> trigramas;
+    trigramas.reserve(descompuesto.size() + 2);
+
+    ushort a = ' ';
+    ushort b = ' ';
+    bool enPalabra = false;
+    for (const QChar c : descompuesto) {
+        // Las marcas diacríticas quedan separadas tras la normalización NFD
+        if (c.category() == QChar::Mark_NonSpacing) continue;
+
+        if (c.isLetterOrNumber()) {
+            const ushort u = c.toLower().unicode();
+            trigramas.append(empaquetar(a, b, u));
+            a = b;
+            b = u;
+            enPalabra = true;
+        } else if (enPalabra) {
+            // Fin de palabra: trigrama final con relleno y reinicio de la ventana
+            trigramas.append(empaquetar(a, b, ' '));
+            a = b = ' ';
+            enPalabra = false;
+        }
+    }
+    if (enPalabra) trigramas.append(empaquetar(a, b, ' '));
+
+    std::sort(trigramas.begin(), trigramas.end());
+    trigramas.erase(std::unique(trigramas.begin(), trigramas.end()), trigramas.end());
+    return trigramas;
+}
+
+// Indexa el texto de un documento; si la clave ya existe la reemplaza
+void TrigramIndex::insert(qint64 key, const QString &texto)
+{
+    if (m_slotPorClave.contains(key)) remove(key);
+
+    const QVector<quint64> trigramas = trigramasDe(texto);
+    const int slot = m_docs.size();
+    m_docs.append({key, int(trigramas.size()), true});
+    m_slotPorClave.insert(key, slot);
+
+    for (quint64 t : trigramas)
+        m_publicaciones[t].append(slot);
+}
+
+// Quita un documento del índice. El slot queda marcado como muerto y las listas
+// de publicación se compactan cuando los muertos superan la mitad del índice.
+void TrigramIndex::remove(qint64 key)
+{
+    auto it = m_slotPorClave.find(key);
+    if (it == m_slotPorClave.end()) return;
+
+    m_docs[it.value()].vivo = false;
+    m_slotPorClave.erase(it);
+    ++m_eliminados;
+
+    if (m_eliminados > 1024 && m_eliminados * 2 > m_docs.size())
+        compactar();
+}
+
+// Reconstruye las listas de publicación sin los documentos eliminados
+void TrigramIndex::compactar()
+{
+    QVector<int> nuevoSlot(m_docs.size(), -1);
+    QVector<Doc> docs;
+    docs.reserve(m_docs.size() - m_eliminados);
+    m_slotPorClave.clear();
+
+    for (int i = 0; i < m_docs.size(); ++i) {
+        if (!m_docs[i].vivo) continue;
+        nuevoSlot[i] = docs.size();
+        m_slotPorClave.insert(m_docs[i].key, docs.size());
+        docs.append(m_docs[i]);
+    }
+
+    for (auto it = m_publicaciones.begin(); it != m_publicaciones.end();) {
+        QVector<int> &lista = it.value();
+        int destino = 0;
+        for (int slot : lista) {
+            if (nuevoSlot[slot] >= 0) lista[destino++] = nuevoSlot[slot];
+        }
+        lista.resize(destino);
+        if (lista.isEmpty())
+            it = m_publicaciones.erase(it);
+        else
+            ++it;
+    }
+
+    m_docs = docs;
+    m_eliminados = 0;
+    m_coincidencias.clear();
+}
+
+// Busca los documentos que comparten más trigramas con la consulta.
+// La puntuación prioriza la cobertura de la consulta (fracción de sus trigramas
+// presentes en el documento) y usa Jaccard para desempatar a favor de los textos
+// más cortos. Solo se recorren las listas de los trigramas de la consulta.
+QVector<TrigramIndex::Hit> TrigramIndex::search(const QString &consulta, int maxResultados,
+                                                float similitudMinima) const
+{
+    QVector<Hit> resultados;
+    const QVector<quint64> trigramas = trigramasDe(consulta);
+    if (trigramas.isEmpty() || maxResultados <= 0) return resultados;
+
+    if (m_coincidencias.size() < m_docs.size())
+        m_coincidencias.resize(m_docs.size());
+    m_tocados.clear();
+
+    // Cuenta cuántos trigramas de la consulta contiene cada documento
+    for (quint64 t : trigramas) {
+        const auto it = m_publicaciones.constFind(t);
+        if (it == m_publicaciones.constEnd()) continue;
+        for (int slot : it.value()) {
+            if (m_coincidencias[slot]++ == 0) m_tocados.append(slot);
+        }
+    }
+
+    const float totalConsulta = float(trigramas.size());
+    for (int slot : m_tocados) {
+        const int comunes = m_coincidencias[slot];
+        m_coincidencias[slot] = 0; // Deja los contadores listos para la próxima búsqueda
+
+        const Doc &doc = m_docs[slot];
+        if (!doc.vivo) continue;
+
+        const float cobertura = comunes / totalConsulta;
+        if (cobertura < similitudMinima) continue;
+
+        const float jaccard = comunes / (totalConsulta + doc.trigramas - comunes);
+        resultados.append({doc.key, 0.75f * cobertura + 0.25f * jaccard});
+    }
+
+    // Ordena por similitud descendente y, a igualdad, por clave
+    const auto mejor = [](const Hit &a, const Hit &b) {
+        return a.score != b.score ? a.score > b.score : a.key < b.key;
+    };
+    if (resultados.size() > maxResultados) {
+        std::partial_sort(resultados.begin(), resultados.begin() + maxResultados,
+                          resultados.end(), mejor);
+        resultados.resize(maxResultados);
+    } else {
+        std::sort(resultados.begin(), resultados.end(), mejor);
+    }
+    return resultados;
+}
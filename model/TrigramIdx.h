@@ -0,0 +1,65 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Índice invertido de trigramas en memoria para la búsqueda tolerante a errores.
+// Cada documento se identifica por una clave (la de ComponentModel::KeyRole: la
+// posición del almacén en los 32 bits altos y el ID del componente) y su texto
+// se descompone en trigramas normalizados (minúsculas y sin acentos).
+class TrigramIndex
+{
+public:
+    // Resultado de una búsqueda: clave del documento y similitud en [0, 1]
+    struct Hit {
+        qint64 key;
+        float score;
+    };
+
+    // Elimina todos los documentos del índice
+    void clear();
+
+    // Reserva espacio para el número de documentos esperado
+    void reserve(int documentos);
+
+    // Indexa el texto de un documento; si la clave ya existe la reemplaza
+    void insert(qint64 key, const QString &texto);
+
+    // Quita un documento del índice (las listas se compactan de forma diferida)
+    void remove(qint64 key);
+
+    // Devuelve los maxResultados documentos más parecidos a la consulta,
+    // ordenados de mayor a menor similitud
+    QVector<Hit> search(const QString &consulta, int maxResultados,
+                        float similitudMinima = 0.3f) const;
+
+    // Número de documentos vivos en el índice
+    int size() const { return m_slotPorClave.size(); }
+
+private:
+    // Documento indexado: clave y número de trigramas distintos
+    struct Doc {
+        qint64 key;
+        int trigramas;
+        bool vivo;
+    };
+
+    // Extrae los trigramas distintos (ordenados) de un texto
+    static QVector<quint64> trigramasDe(const QString &texto);
+
+    // Reconstruye las listas de publicación sin los documentos eliminados
+    void compactar();
+
+    QVector<Doc> m_docs;                         // Documentos por posición (slot)
+    QHash<qint64, int> m_slotPorClave;           // Clave -> slot en m_docs
+    QHash<quint64, QVector<int>> m_publicaciones; // Trigrama -> slots que lo contienen
+    int m_eliminados = 0;                        // Slots muertos pendientes de compactar
+
+    // Contadores reutilizados entre búsquedas para no reservar memoria cada vez
+    mutable QVector<quint16> m_coincidencias;
+    mutable QVector<int> m_tocados;
+};
+
+#endif // TRIGRAMINDEX_H
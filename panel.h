@@ -2,10 +2,13 @@
 #define INVENTARIO_H
 
 #include "DataHub/DBControl.h"
+#include "DataHub/DBBackup.h"
 #include "model/CompList.h"
+#include "model/FiltProxy.h"
 
 #include <QMainWindow>
-#include <QSortFilterProxyModel>
+
+class ComponentDialog;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class Inventario; }
@@ -22,16 +25,30 @@ public:
 private slots:
     void on_filtrarPorTipo(int index);
     void on_buscarTextoCambiado(const QString &texto);
+    void on_modoDifusoCambiado(bool activo);
     void on_anadirClicked();
     void on_editarClicked();
     void on_eliminarClicked();
     void on_reporteClicked();
+    void on_exportarCambiosClicked();
+    void on_respaldarAhora();
+    void on_restaurarRespaldo();
+    void on_programarRespaldo();
+    void on_respaldoTerminado(bool ok, const QString &archivoOError);
 
 private:
     void configurarBusqueda();
+    void aplicarBusqueda();
+    Component componenteDelDialogo(const ComponentDialog &dialog) const;
+    void configurarRespaldos();
+    QString rutaConfiguracion() const;
+    QString directorioRespaldos() const;
     Ui::Inventario *ui;
     DatabaseManager *m_dbManager;
     ComponentModel* m_componentModel;
-    QSortFilterProxyModel* m_proxyModel;
+    CustomFilterProxyModel* m_proxyModel;
+    BackupManager* m_backupManager;
+    int m_columnaOrden = 1;              // Orden del usuario, guardado durante la búsqueda difusa
+    Qt::SortOrder m_orden = Qt::AscendingOrder;
 };
 #endif // INVENTARIO_H
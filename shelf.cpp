@@ -1,7 +1,8 @@
 #include "panel.h"
 #include "ui_main.h"
 #include "compItem/CompForm.h" 
-#include "model/FiltProxy.h"
+#include "model/CellDeleg.h"
+#include "DataHub/ChangeExport.h"
 #include <QMessageBox>
 #include <QDebug>
 #include <QString>
@@ -14,6 +15,14 @@
 #include <QPdfWriter>
 #include <QPainter>
 #include <QRegularExpression>  // Qt6: para reemplazar QRegExp
+#include <QSettings>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QMenuBar>
+#include <QHeaderView>
+
+// Número máximo de filas que muestra la búsqueda difusa
+static const int MAX_RESULTADOS_DIFUSOS = 200;
 
 Inventario::Inventario(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::Inventario)
@@ -24,12 +33,17 @@ Inventario::Inventario(QWidget *parent)
     m_dbManager = new DatabaseManager(this);
 
     // 2. Abre la base de datos ANTES de crear los modelos
+    //    Los almacenes adicionales se leen de inventario.ini ([almacenes] sitio=ruta)
     QString dbPath = QDir::current().absoluteFilePath("inventario.db");
-    if (!m_dbManager->initialize(dbPath)) {
+    QStringList almacenesFallidos;
+    if (!m_dbManager->initializeFromConfig(dbPath, &almacenesFallidos)) {
         QMessageBox::critical(this, "Error", "No se pudo iniciar la base de datos");
         qApp->exit(1);
         return;
     }
+    for (const QString &sitio : almacenesFallidos) {
+        QMessageBox::warning(this, "Error", "No se pudo abrir el almacén " + sitio);
+    }
 
     // 3. Crea los modelos
     m_componentModel = new ComponentModel(m_dbManager, this);
@@ -49,6 +63,7 @@ Inventario::Inventario(QWidget *parent)
     ui->tableView->setSelectionMode(QAbstractItemView::SingleSelection);
     ui->tableView->setSortingEnabled(true);
     ui->tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    CachedCellDelegate::configurarVista(ui->tableView); // Delegado con caché y filas de altura fija
 
     // 7. Implementación de la ventana refresh
     ui->comboFiltrarTipo->addItems({"Todos", "Electrónico", "Mecánico", "Herramienta", "Consumible"});
@@ -57,6 +72,18 @@ Inventario::Inventario(QWidget *parent)
     connect(ui->lineEditBuscar, &QLineEdit::textChanged,
             this, &Inventario::on_buscarTextoCambiado);
 
+    connect(ui->checkBusquedaDifusa, &QCheckBox::toggled,
+            this, &Inventario::on_modoDifusoCambiado);
+
+    // Tras cada cambio del modelo se repite la búsqueda difusa activa
+    auto repetirBusquedaDifusa = [this]() {
+        if (m_proxyModel->modoDifuso()) aplicarBusqueda();
+    };
+    connect(m_componentModel, &QAbstractItemModel::modelReset, this, repetirBusquedaDifusa);
+    connect(m_componentModel, &QAbstractItemModel::rowsInserted, this, repetirBusquedaDifusa);
+    connect(m_componentModel, &QAbstractItemModel::rowsRemoved, this, repetirBusquedaDifusa);
+    connect(m_componentModel, &QAbstractItemModel::dataChanged, this, repetirBusquedaDifusa);
+
     connect(ui->btnAnadir, &QPushButton::clicked,
             this, &Inventario::on_anadirClicked);
 
@@ -69,11 +96,17 @@ Inventario::Inventario(QWidget *parent)
     connect(ui->btnReporte, &QPushButton::clicked,
             this, &Inventario::on_reporteClicked);
 
+    connect(ui->btnExportarCambios, &QPushButton::clicked,
+            this, &Inventario::on_exportarCambiosClicked);
+
     connect(ui->tableView, &QTableView::doubleClicked,
             this, &Inventario::on_editarClicked);
 
     connect(ui->comboFiltrarTipo, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &Inventario::on_filtrarPorTipo);
+
+    // 9. Respaldos en línea
+    configurarRespaldos();
 }
 
 Inventario::~Inventario()
@@ -92,11 +125,52 @@ void Inventario::configurarBusqueda()
 
 // Qt6: reemplazo QRegExp por QRegularExpression
 void Inventario::on_buscarTextoCambiado(const QString &texto)
+{
+    Q_UNUSED(texto);
+    aplicarBusqueda();
+}
+
+void Inventario::on_modoDifusoCambiado(bool activo)
+{
+    Q_UNUSED(activo);
+    aplicarBusqueda();
+}
+
+// Aplica el texto de búsqueda según el modo seleccionado
+void Inventario::aplicarBusqueda()
 {
     if (!m_proxyModel || !m_componentModel) return;
 
-    QRegularExpression regex(texto, QRegularExpression::CaseInsensitiveOption);
-    m_proxyModel->setFilterRegularExpression(regex);
+    const QString texto = ui->lineEditBuscar->text();
+
+    QHeaderView *cabecera = ui->tableView->horizontalHeader();
+
+    if (ui->checkBusquedaDifusa->isChecked() && !texto.trimmed().isEmpty()) {
+        // Al entrar en modo difuso se guarda el orden elegido por el usuario
+        if (!m_proxyModel->modoDifuso()) {
+            m_columnaOrden = cabecera->sortIndicatorSection();
+            m_orden = cabecera->sortIndicatorOrder();
+        }
+
+        // Modo difuso: índice de trigramas, resultados ordenados por similitud
+        m_proxyModel->setFilterRegularExpression(QRegularExpression());
+        m_proxyModel->setResultadosDifusos(
+            m_componentModel->buscarDifuso(texto, MAX_RESULTADOS_DIFUSOS));
+        ui->tableView->sortByColumn(0, Qt::AscendingOrder);
+    } else {
+        // Al salir del modo difuso se recupera el orden anterior
+        if (m_proxyModel->modoDifuso()) {
+            m_proxyModel->limpiarResultadosDifusos();
+            ui->tableView->sortByColumn(m_columnaOrden, m_orden);
+        }
+
+        // Un patrón mal escrito se busca como texto literal en lugar de no mostrar nada
+        QRegularExpression regex(texto, QRegularExpression::CaseInsensitiveOption);
+        if (!regex.isValid()) {
+            regex.setPattern(QRegularExpression::escape(texto));
+        }
+        m_proxyModel->setFilterRegularExpression(regex);
+    }
 
     ui->tableView->viewport()->update();
 }
@@ -113,25 +187,37 @@ void Inventario::on_filtrarPorTipo(int index)
         default: tipoFiltro = "";
     }
 
-    m_proxyModel->setFilterKeyColumn(2); // Columna de tipo
-    m_proxyModel->setFilterFixedString(tipoFiltro);
+    // El tipo tiene su propio filtro: la expresión regular es la del texto de búsqueda
+    m_proxyModel->setFilterTipo(tipoFiltro);
+}
 
-    if (tipoFiltro.isEmpty()) {
-        m_proxyModel->setFilterWildcard("*");
-    }
+// Datos introducidos en el diálogo (sin ID; el almacén vacío es el principal)
+Component Inventario::componenteDelDialogo(const ComponentDialog &dialog) const
+{
+    Component componente;
+    componente.name = dialog.nombre();
+    componente.type = dialog.tipo();
+    componente.quantity = dialog.cantidad();
+    componente.location = dialog.ubicacion();
+    componente.purchaseDate = dialog.fechaAdquisicion();
+    componente.site = dialog.sitio().isEmpty() ? m_dbManager->sites().first() : dialog.sitio();
+    return componente;
 }
 
 void Inventario::on_anadirClicked() {
-    ComponentDialog dialog(this);
+    ComponentDialog dialog(this, "", "", 1, "", QDate::currentDate(), m_dbManager->sites());
     if (dialog.exec() == QDialog::Accepted) {
+        Component nuevo = componenteDelDialogo(dialog);
         if (m_dbManager->addComponent(
-                dialog.nombre(),
-                dialog.tipo(),
-                dialog.cantidad(),
-                dialog.ubicacion(),
-                dialog.fechaAdquisicion()))
+                nuevo.name,
+                nuevo.type,
+                nuevo.quantity,
+                nuevo.location,
+                nuevo.purchaseDate,
+                nuevo.site,
+                &nuevo.id))
         {
-            m_componentModel->refresh();
+            m_componentModel->componenteAnadido(nuevo);
             QMessageBox::information(this, "Éxito", "Componente añadido correctamente");
         } else {
             QMessageBox::warning(this, "Error", "No se pudo añadir el componente");
@@ -150,28 +236,58 @@ void Inventario::on_editarClicked()
 
     QModelIndex sourceIndex = m_proxyModel->mapToSource(proxyIndex);
 
-    int id = m_componentModel->data(m_componentModel->index(sourceIndex.row(), 0)).toInt();
-    QString nombre = m_componentModel->data(m_componentModel->index(sourceIndex.row(), 1)).toString();
-    QString tipo = m_componentModel->data(m_componentModel->index(sourceIndex.row(), 2)).toString();
-    int cantidad = m_componentModel->data(m_componentModel->index(sourceIndex.row(), 3)).toInt();
-    QString ubicacion = m_componentModel->data(m_componentModel->index(sourceIndex.row(), 4)).toString();
-    QDate fecha = QDate::fromString(
-        m_componentModel->data(m_componentModel->index(sourceIndex.row(), 5)).toString(),
-        Qt::ISODate
-    );
+    const Component componente = m_componentModel->component(sourceIndex.row());
+    const qint64 id = componente.id;
+    const QString sitio = componente.site;
 
-    ComponentDialog dialog(this, nombre, tipo, cantidad, ubicacion, fecha);
+    ComponentDialog dialog(this, componente.name, componente.type, componente.quantity,
+                           componente.location, componente.purchaseDate,
+                           m_dbManager->sites(), sitio);
 
     if (dialog.exec() == QDialog::Accepted) {
-        if (m_dbManager->actualizarComponente(
+        Component editado = componenteDelDialogo(dialog);
+        bool ok;
+        if (editado.site == sitio) {
+            editado.id = id;
+            ok = m_dbManager->actualizarComponente(
                 id,
-                dialog.nombre(),
-                dialog.tipo(),
-                dialog.cantidad(),
-                dialog.ubicacion(),
-                dialog.fechaAdquisicion()))
+                editado.name,
+                editado.type,
+                editado.quantity,
+                editado.location,
+                editado.purchaseDate,
+                sitio);
+            if (ok) m_componentModel->componenteActualizado(editado);
+        } else {
+            // Cambio de almacén: se crea en el nuevo y se elimina del anterior. Si no se
+            // puede eliminar, se deshace el alta para que no quede en los dos almacenes
+            ok = m_dbManager->addComponent(
+                editado.name,
+                editado.type,
+                editado.quantity,
+                editado.location,
+                editado.purchaseDate,
+                editado.site,
+                &editado.id);
+            if (ok && !m_dbManager->eliminarComponente(id, sitio)) {
+                ok = false;
+                if (!m_dbManager->eliminarComponente(editado.id, editado.site)) {
+                    QMessageBox::critical(this, "Error",
+                                          QString("El componente quedó en los almacenes %1 y %2; "
+                                                  "elimina uno de ellos")
+                                              .arg(sitio, editado.site));
+                    m_componentModel->componenteAnadido(editado);
+                    return;
+                }
+            }
+            if (ok) {
+                m_componentModel->componenteEliminado(id, sitio);
+                m_componentModel->componenteAnadido(editado);
+            }
+        }
+
+        if (ok)
         {
-            m_componentModel->refresh();
             QMessageBox::information(this, "Éxito", "Componente actualizado correctamente");
         } else {
             QMessageBox::warning(this, "Error", "No se pudo actualizar el componente");
@@ -182,9 +298,10 @@ void Inventario::on_editarClicked()
 void Inventario::on_eliminarClicked() {
     QModelIndex index = ui->tableView->currentIndex();
     if (index.isValid()) {
-        QString id = m_componentModel->data(m_componentModel->index(index.row(), 0)).toString();
-        if (m_dbManager->eliminarComponente(id)) {
-            m_componentModel->refresh();
+        const Component componente =
+            m_componentModel->component(m_proxyModel->mapToSource(index).row());
+        if (m_dbManager->eliminarComponente(componente.id, componente.site)) {
+            m_componentModel->componenteEliminado(componente.id, componente.site);
             QMessageBox::information(this, "Éxito", "Componente eliminado correctamente");
         } else {
             QMessageBox::warning(this, "Error", "No se pudo eliminar el componente");
@@ -192,10 +309,140 @@ void Inventario::on_eliminarClicked() {
     }
 }
 
+// Crea el menú de respaldos y recupera la programación guardada
+void Inventario::configurarRespaldos()
+{
+    m_backupManager = new BackupManager(this);
+    connect(m_backupManager, &BackupManager::respaldoTerminado,
+            this, &Inventario::on_respaldoTerminado);
+
+    QMenu *menuRespaldo = menuBar()->addMenu("Respaldo");
+    menuRespaldo->addAction("Respaldar ahora", this, &Inventario::on_respaldarAhora);
+    menuRespaldo->addAction("Restaurar...", this, &Inventario::on_restaurarRespaldo);
+    menuRespaldo->addAction("Programar...", this, &Inventario::on_programarRespaldo);
+
+    QSettings config(rutaConfiguracion(), QSettings::IniFormat);
+    m_backupManager->programar(m_dbManager->databasePaths(), directorioRespaldos(),
+                               config.value("respaldo/intervaloMinutos", 0).toInt());
+}
+
+// Archivo de configuración junto a la base de datos
+QString Inventario::rutaConfiguracion() const
+{
+    return QFileInfo(m_dbManager->databasePath()).dir().filePath("inventario.ini");
+}
+
+// Directorio de respaldos (configurable, por defecto "respaldos" junto a la base de datos)
+QString Inventario::directorioRespaldos() const
+{
+    QSettings config(rutaConfiguracion(), QSettings::IniFormat);
+    return config.value("respaldo/directorio",
+                        QFileInfo(m_dbManager->databasePath()).dir().filePath("respaldos"))
+        .toString();
+}
+
+void Inventario::on_respaldarAhora()
+{
+    if (m_backupManager->ocupado()) {
+        QMessageBox::information(this, "Respaldo", "Ya hay un respaldo en curso");
+        return;
+    }
+    statusBar()->showMessage("Creando respaldo...");
+    m_backupManager->respaldarEnSegundoPlano(m_dbManager->databasePaths(), directorioRespaldos());
+}
+
+void Inventario::on_respaldoTerminado(bool ok, const QString &archivoOError)
+{
+    if (ok) {
+        statusBar()->showMessage("Respaldo creado: " + QFileInfo(archivoOError).fileName(), 10000);
+    } else {
+        statusBar()->clearMessage();
+        QMessageBox::warning(this, "Error", "No se pudo crear el respaldo:\n" + archivoOError);
+    }
+}
+
+void Inventario::on_restaurarRespaldo()
+{
+    QString archivo = QFileDialog::getOpenFileName(this, "Restaurar respaldo",
+                                                   directorioRespaldos(), "Respaldos (*.ibk)");
+    if (archivo.isEmpty()) return;
+
+    if (QMessageBox::question(this, "Restaurar",
+                              "Se reemplazarán todos los datos actuales por los del respaldo. "
+                              "La próxima exportación de cambios enviará el inventario completo. "
+                              "¿Continuar?")
+        != QMessageBox::Yes) {
+        return;
+    }
+
+    // Cada almacén tiene su propia cadena de respaldos; la cabecera indica de cuál es
+    QString destino;
+    for (const QString &ruta : m_dbManager->databasePaths()) {
+        if (BackupManager::esRespaldoDe(archivo, ruta)) destino = ruta;
+    }
+    if (destino.isEmpty()) {
+        QMessageBox::warning(this, "Error", "El respaldo no corresponde a ningún almacén");
+        return;
+    }
+
+    QString error;
+    if (BackupManager::restaurarConAplicacionAbierta(archivo, destino, &error)) {
+        m_componentModel->refresh();
+        QMessageBox::information(this, "Éxito", "Respaldo restaurado correctamente");
+    } else {
+        QMessageBox::warning(this, "Error", "No se pudo restaurar el respaldo:\n" + error);
+    }
+}
+
+void Inventario::on_programarRespaldo()
+{
+    QSettings config(rutaConfiguracion(), QSettings::IniFormat);
+    bool ok = false;
+    int minutos = QInputDialog::getInt(this, "Programar respaldo",
+                                       "Intervalo en minutos (0 = desactivado):",
+                                       config.value("respaldo/intervaloMinutos", 0).toInt(),
+                                       0, 7 * 24 * 60, 1, &ok);
+    if (!ok) return;
+
+    config.setValue("respaldo/intervaloMinutos", minutos);
+    m_backupManager->programar(m_dbManager->databasePaths(), directorioRespaldos(), minutos);
+}
+
+// Exportación incremental: solo los cambios desde la última exportación
+void Inventario::on_exportarCambiosClicked()
+{
+    QString defaultPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+    QString ruta = QFileDialog::getSaveFileName(this, "Exportar cambios",
+                                                defaultPath + "/cambios.jsonl",
+                                                "JSON Lines (*.jsonl);;CSV (*.csv)");
+    if (ruta.isEmpty()) return;
+
+    int filas = 0;
+    QString error;
+    if (ChangeExporter::exportar(*m_dbManager, ruta, ChangeExporter::formatoPorExtension(ruta),
+                                 "erp", &filas, &error)) {
+        QMessageBox::information(this, "Exportar cambios",
+                                 QString("Se exportaron %1 cambios").arg(filas));
+    } else {
+        QMessageBox::warning(this, "Error", "No se pudieron exportar los cambios:\n" + error);
+    }
+}
+
+// Fila de texto de un componente para los reportes CSV y PDF
+static QStringList filaReporte(const Component &componente)
+{
+    return {QString::number(componente.id), componente.name, componente.type,
+            QString::number(componente.quantity), componente.location,
+            componente.purchaseDate.toString(Qt::ISODate), componente.site};
+}
+
 // Qt6: QTextStream::setCodec eliminado
 void Inventario::on_reporteClicked()
 {
-    QVector<QStringList> componentes = m_dbManager->getAllComponents();
+    QVector<QStringList> componentes;
+    for (const Component &componente : m_dbManager->getAllComponents()) {
+        componentes.append(filaReporte(componente));
+    }
 
     QString defaultPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
 
@@ -207,7 +454,7 @@ void Inventario::on_reporteClicked()
     if (csvFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
         QTextStream out(&csvFile);
         out << QChar(0xFEFF);
-        out << "ID,Nombre,Tipo,Cantidad,Ubicacion,Fecha de compra\n";
+        out << "ID,Nombre,Tipo,Cantidad,Ubicacion,Fecha de compra,Sitio\n";
 
         for (const QStringList &row : componentes) {
             QStringList escapedRow;
@@ -236,7 +483,7 @@ void Inventario::on_reporteClicked()
     font.setBold(true);
     painter.setFont(font);
 
-    QStringList headers = {"ID", "Nombre", "Tipo", "Cantidad", "Ubicación", "Fecha de compra"};
+    QStringList headers = {"ID", "Nombre", "Tipo", "Cantidad", "Ubicación", "Fecha de compra", "Sitio"};
 
     QFontMetrics metrics(painter.font());
     QVector<int> colWidths(headers.size(), 0);
@@ -301,6 +548,24 @@ void Inventario::on_reporteClicked()
             painter.setFont(font);
         }
     }
+
+    // Totales por tipo de todos los almacenes
+    const QMap<QString, int> totales = m_dbManager->cantidadPorTipo();
+    y += rowHeight;
+    if (y + (totales.size() + 1) * rowHeight > pdfWriter.height() - 100) {
+        pdfWriter.newPage();
+        y = 100;
+    }
+    font.setBold(true);
+    painter.setFont(font);
+    painter.drawText(colX[0] + 5, y, "Totales por tipo");
+    font.setBold(false);
+    painter.setFont(font);
+    for (auto it = totales.constBegin(); it != totales.constEnd(); ++it) {
+        y += rowHeight;
+        painter.drawText(colX[0] + 5, y, it.key());
+        painter.drawText(colX[3] + 5, y, QString::number(it.value()));
+    }
     painter.end();
 
     QMessageBox::information(this, "Reporte", "Reportes CSV y PDF generados correctamente.");
@@ -0,0 +1,208 @@
+// Prueba de la exportación incremental con varios consumidores.
+//
+// El consumidor "erp" exporta dos veces y con ello poda el diario de cambios.
+// Después se incorpora "contabilidad", que debe recibir el catálogo completo
+// (reset + altas) aunque el diario ya no contenga las altas originales. Para ambos
+// consumidores, aplicar sus exportaciones en orden debe dar el estado de la base
+// de datos.
+//
+// Con dos almacenes, cuyos IDs se repiten, la reproducción debe distinguir los
+// componentes por sitio, y al restaurar solo un almacén su "reset" debe descartar
+// únicamente lo recibido de ese almacén.
+
+#include "DataHub/DBControl.h"
+#include "DataHub/ChangeExport.h"
+#include "TestUtil.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+// Operaciones ("op") de un archivo exportado, en orden
+static QStringList operaciones(const QString &ruta)
+{
+    QStringList ops;
+    QFile archivo(ruta);
+    if (archivo.open(QIODevice::ReadOnly)) {
+        while (!archivo.atEnd()) {
+            ops << QJsonDocument::fromJson(archivo.readLine()).object().value("op").toString();
+        }
+    }
+    return ops;
+}
+
+// Exporta los cambios pendientes del consumidor a un archivo nuevo
+static QString exportar(DatabaseManager &db, const QTemporaryDir &dir, const QString &consumidor,
+                        QStringList &fallos)
+{
+    static int numero = 0;
+    const QString ruta = dir.filePath(QString("%1_%2.jsonl").arg(consumidor).arg(numero++));
+    if (!ChangeExporter::exportar(db, ruta, ChangeExporter::JsonLines, consumidor)) {
+        fallos << "No se pudo exportar para " + consumidor;
+    }
+    return ruta;
+}
+
+// Comprueba que lo reconstruido coincide con la base de datos
+static void comparar(const QString &consumidor,
+                     const QMap<ClaveComponente, Component> &reconstruido,
+                     const QVector<Component> &real, QStringList &fallos)
+{
+    bool iguales = reconstruido.size() == real.size();
+    for (const Component &c : real) {
+        const Component r = reconstruido.value(clave(c));
+        iguales = iguales && r.id == c.id && r.name == c.name && r.type == c.type
+                  && r.quantity == c.quantity && r.location == c.location
+                  && r.purchaseDate == c.purchaseDate && r.site == c.site;
+    }
+    if (!iguales) {
+        fallos << QString("%1: las exportaciones no reconstruyen el inventario").arg(consumidor);
+    }
+}
+
+// Simula la restauración de un almacén a un estado anterior: desaparece un
+// componente sin pasar por el diario y se borran las marcas de exportación
+static bool restaurarAlmacen(const QString &ruta, qint64 idPerdido)
+{
+    bool ok;
+    {
+        QSqlDatabase conexion = QSqlDatabase::addDatabase("QSQLITE", "prueba_restauracion");
+        conexion.setDatabaseName(ruta);
+        QSqlQuery query(conexion);
+        ok = conexion.open()
+             && query.exec(QString("DELETE FROM components WHERE id = %1").arg(idPerdido))
+             && query.exec("DELETE FROM component_changes")
+             && query.exec("DELETE FROM export_watermarks");
+    }
+    QSqlDatabase::removeDatabase("prueba_restauracion");
+    return ok;
+}
+
+// Dos almacenes con los mismos IDs; después se restaura solo uno de ellos
+static void dosAlmacenes(const QTemporaryDir &dir, QStringList &fallos)
+{
+    DatabaseManager db;
+    const QString rutaNorte = dir.filePath("multi-norte.db");
+    if (!db.initialize(dir.filePath("multi.db"), "Principal") || !db.addShard("Norte", rutaNorte)) {
+        fallos << "Dos almacenes: no se pudo preparar la base de datos";
+        return;
+    }
+
+    const QDate fecha(2024, 3, 15);
+    qint64 idPrincipal = 0;
+    qint64 idNorte = 0;
+    qint64 idNorte2 = 0;
+    db.addComponent("Resistencia 220", "Electrónico", 50, "Cajón 1", fecha, "Principal", &idPrincipal);
+    db.addComponent("Tornillo M3", "Mecánico", 200, "Cajón 2", fecha, "Norte", &idNorte);
+    db.addComponent("Soldador", "Herramienta", 2, "Estante 4", fecha, "Norte", &idNorte2);
+    if (idPrincipal != idNorte) {
+        fallos << "Dos almacenes: se esperaban IDs repetidos entre almacenes";
+    }
+
+    // Catálogo completo: un reset por almacén
+    QStringList archivos = {exportar(db, dir, "erp", fallos)};
+    if (operaciones(archivos.last()).count("reset") != 2) {
+        fallos << "Dos almacenes: la primera exportación no tiene un reset por almacén";
+    }
+
+    // Cambios con el mismo ID en los dos almacenes
+    db.actualizarComponente(idNorte, "Tornillo M3", "Mecánico", 150, "Cajón 2", fecha, "Norte");
+    db.eliminarComponente(idPrincipal, "Principal");
+    db.addComponent("Condensador 10uF", "Electrónico", 30, "Cajón 3", fecha, "Principal");
+    archivos << exportar(db, dir, "erp", fallos);
+    comparar("Dos almacenes", reproducirExportaciones(archivos, fallos), db.getAllComponents(),
+             fallos);
+
+    // Restaurar Norte: solo Norte se envía de nuevo, y su reset descarta el componente perdido
+    if (!restaurarAlmacen(rutaNorte, idNorte2)) {
+        fallos << "Dos almacenes: no se pudo simular la restauración";
+        return;
+    }
+    archivos << exportar(db, dir, "erp", fallos);
+    if (operaciones(archivos.last()) != QStringList({"reset", "insert"})) {
+        fallos << "Dos almacenes: tras restaurar Norte no se recibió solo su catálogo";
+    }
+    comparar("Dos almacenes tras restaurar", reproducirExportaciones(archivos, fallos),
+             db.getAllComponents(), fallos);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QStringList fallos;
+
+    QTemporaryDir dir;
+    DatabaseManager db;
+    if (!dir.isValid() || !db.initialize(dir.filePath("inventario.db"))) {
+        out << "No se pudo preparar la base de datos\n";
+        return 1;
+    }
+
+    const QDate fecha(2024, 3, 15);
+    qint64 idA = 0;
+    qint64 idB = 0;
+    db.addComponent("Resistencia 220", "Electrónico", 50, "Cajón 1", fecha, QString(), &idA);
+    db.addComponent("Tornillo M3", "Mecánico", 200, "Cajón 2", fecha, QString(), &idB);
+    db.addComponent("Soldador", "Herramienta", 2, "Estante 4", fecha);
+
+    // Primera exportación de erp: catálogo completo
+    QStringList archivosErp;
+    archivosErp << exportar(db, dir, "erp", fallos);
+    if (operaciones(archivosErp.last()) != QStringList({"reset", "insert", "insert", "insert"})) {
+        fallos << "erp: la primera exportación no es el catálogo completo";
+    }
+
+    // Cambios y segunda exportación de erp: solo los cambios
+    db.actualizarComponente(idA, "Resistencia 220", "Electrónico", 45, "Cajón 1", fecha);
+    db.eliminarComponente(idB);
+    db.addComponent("Condensador 10uF", "Electrónico", 30, "Cajón 3", fecha);
+    archivosErp << exportar(db, dir, "erp", fallos);
+    QStringList ops = operaciones(archivosErp.last());
+    ops.sort();
+    if (ops != QStringList({"delete", "insert", "update"})) {
+        fallos << "erp: la segunda exportación no contiene solo los tres cambios";
+    }
+
+    // Con un único consumidor, el diario queda podado por completo
+    {
+        QSqlDatabase conexion = QSqlDatabase::addDatabase("QSQLITE", "prueba_diario");
+        conexion.setDatabaseName(dir.filePath("inventario.db"));
+        QSqlQuery query(conexion);
+        if (!conexion.open() || !query.exec("SELECT COUNT(*) FROM component_changes")
+            || !query.next() || query.value(0).toInt() != 0) {
+            fallos << "El diario de cambios no se podó tras exportar";
+        }
+    }
+    QSqlDatabase::removeDatabase("prueba_diario");
+
+    // Un consumidor nuevo tras la poda recibe el catálogo actual completo
+    const QStringList archivosContabilidad = {exportar(db, dir, "contabilidad", fallos)};
+    if (operaciones(archivosContabilidad.last())
+        != QStringList({"reset", "insert", "insert", "insert"})) {
+        fallos << "contabilidad: no recibió el catálogo completo tras la poda";
+    }
+
+    // Ya registrado, no hay nada nuevo que exportar
+    if (!operaciones(exportar(db, dir, "contabilidad", fallos)).isEmpty()) {
+        fallos << "contabilidad: la exportación sin cambios no está vacía";
+    }
+
+    const QVector<Component> real = db.getAllComponents();
+    comparar("erp", reproducirExportaciones(archivosErp, fallos), real, fallos);
+    comparar("contabilidad", reproducirExportaciones(archivosContabilidad, fallos), real, fallos);
+
+    dosAlmacenes(dir, fallos);
+
+    if (!fallos.isEmpty()) {
+        for (const QString &fallo : fallos) out << "FALLO: " << fallo << '\n';
+        return 1;
+    }
+    out << "Correcto\n";
+    return 0;
+}
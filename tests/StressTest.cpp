@@ -0,0 +1,818 @@
+// Prueba de concurrencia y de regresión de latencia de la capa de datos.
+//
+// Antes de nada, varios hilos abren a la vez una base de datos con el esquema
+// antiguo (purchase_date TEXT): todos deben abrirla y la migración y la siembra
+// del diario de cambios deben hacerse una sola vez.
+//
+// Después, sobre un inventario.db temporal, varios hilos escritores dan de alta,
+// modifican y eliminan componentes mientras otros hilos buscan y consultan por
+// fechas, un hilo exporta el diario de cambios y el hilo principal recarga
+// ComponentModel. Cada hilo usa su propio DatabaseManager, abierto a la vez que los
+// demás, como lo harían procesos distintos. Todos los escritores modifican además
+// unas pocas filas compartidas con actualizarComponente. Al terminar:
+//  - cada fila compartida debe tener, completa, una de las escrituras confirmadas
+//    y ninguna escritura confirmada puede haber empezado después de que acabara
+//    esa (si no, la posterior se habría perdido);
+//  - el resto del estado final debe coincidir con lo que cada escritor sabe que
+//    escribió y con lo reconstruido a partir de las exportaciones;
+//  - ComponentModel debe coincidir con la base de datos;
+//  - con --referencia, las latencias p50/p99 (y el rendimiento, si figura) de
+//    cada operación no deben superar las del archivo, que tiene que ser del mismo
+//    perfil. Puede ser un presupuesto fijo, como tests/baselines/stress.ini, o una
+//    medición guardada con --guardar-referencia;
+//  - además, no deben empeorar más allá de la tolerancia respecto a una ejecución
+//    con un hilo de cada tipo hecha antes en el mismo proceso. Las latencias
+//    admitidas crecen en proporción al número de hilos, porque SQLite serializa
+//    las escrituras.
+//
+// Uso: StressTest [--escritores N] [--lectores N] [--operaciones N] [--filas N]
+//                 [--tolerancia F] [--referencia archivo.ini] [--guardar-referencia]
+
+#include "DataHub/DBControl.h"
+#include "DataHub/ChangeExport.h"
+#include "model/CompList.h"
+#include "TestUtil.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QRandomGenerator>
+#include <QSemaphore>
+#include <QSettings>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+// Consumidor de la exportación de cambios usado por la prueba
+static const QString CONSUMIDOR = "estres";
+
+// Máximo de diferencias que se listan por comprobación
+static const int MAX_DIFERENCIAS = 10;
+
+// Filas que modifican todos los escritores
+static const int FILAS_COMPARTIDAS = 4;
+
+// Hilos que abren a la vez la base de datos con el esquema antiguo
+static const int APERTURAS_CONCURRENTES = 8;
+
+// Con menos muestras los percentiles no son fiables y no se comparan
+static const int MIN_MUESTRAS = 20;
+
+// Margen absoluto (ms) de las latencias admitidas. Mientras espera el bloqueo, el
+// gestor de espera de SQLite duerme en pasos de hasta 25 ms, así que con contención
+// una latencia puede pasar de la referencia escalada en un paso sin ser regresión
+static const double MARGEN_MS = 25.0;
+
+// Latencias (µs) de cada operación
+using Muestras = QMap<QString, QVector<qint64>>;
+
+// Escritura confirmada sobre una fila compartida y cuándo empezó y acabó (ns)
+struct Escritura {
+    Component valor;
+    qint64 inicio = 0;
+    qint64 fin = 0;
+};
+
+// Lo que devuelve cada hilo de trabajo
+struct Resultado {
+    Muestras muestras;
+    QMap<qint64, Component> esperado;     // Estado final de las filas de un escritor
+    QVector<Escritura> compartidas;       // Escrituras confirmadas en filas compartidas
+    QStringList errores;
+};
+
+// Estado compartido por los hilos
+struct Contexto {
+    QString ruta;
+    QVector<Component> compartidas;  // Valores iniciales de las filas compartidas
+    QElapsedTimer reloj;             // Reloj común para ordenar las escrituras
+    QSemaphore listos;               // Hilos con su base de datos abierta
+    QSemaphore salida;               // Señal de inicio común
+    std::atomic<bool> terminar{false};
+};
+
+// Resumen de una operación
+struct Estadistica {
+    int operaciones = 0;
+    double p50 = 0;          // ms
+    double p99 = 0;          // ms
+    double maximo = 0;       // ms
+    double rendimiento = 0;  // operaciones por segundo
+};
+
+// Resultado de una ejecución completa
+struct Ejecucion {
+    Muestras muestras;
+    double segundos = 0;
+    int componentes = 0;     // Componentes al final
+    QStringList fallos;      // Fallos de correctitud
+};
+
+// Mide una operación y guarda su latencia; anota un error si falla
+template <typename Fn>
+static void medir(Resultado &r, const QString &operacion, Fn fn)
+{
+    QElapsedTimer reloj;
+    reloj.start();
+    const bool ok = fn();
+    r.muestras[operacion].append(reloj.nsecsElapsed() / 1000);
+    if (!ok) r.errores << QString("Falló la operación %1").arg(operacion);
+}
+
+// Abre el DatabaseManager del hilo (a la vez que los demás hilos) y espera la
+// señal de inicio común
+static bool abrir(DatabaseManager &db, Contexto &ctx)
+{
+    const bool ok = db.initialize(ctx.ruta);
+    ctx.listos.release();
+    ctx.salida.acquire();
+    return ok;
+}
+
+// Escritor: mezcla altas, modificaciones y bajas sobre sus propias filas y
+// recuerda el estado que deberían tener al final. Además sobrescribe las filas
+// compartidas con valores que solo él escribe y anota las escrituras confirmadas
+static void escritor(Contexto &ctx, int n, int operaciones, Resultado &r)
+{
+    DatabaseManager db;
+    if (!abrir(db, ctx)) {
+        r.errores << QString("El escritor %1 no pudo abrir la base de datos").arg(n);
+        return;
+    }
+
+    QRandomGenerator azar(1000 + n);
+    const QStringList tipos = tiposDePrueba();
+    const QString sitio = db.sites().first();
+    const QDate hoy = QDate::currentDate();
+    QVector<qint64> vivos;
+
+    for (int i = 0; i < operaciones; ++i) {
+        const int tirada = azar.bounded(100);
+        if (vivos.isEmpty() || tirada < 35) {
+            Component c;
+            c.name = QString("Escritor %1 componente %2").arg(n).arg(i);
+            c.type = tipos[azar.bounded(tipos.size())];
+            c.quantity = azar.bounded(100);
+            c.location = QString("Estante E%1-%2").arg(n).arg(i);
+            c.purchaseDate = hoy.addDays(-azar.bounded(2000));
+            c.site = sitio;
+            medir(r, "alta", [&] {
+                return db.addComponent(c.name, c.type, c.quantity, c.location,
+                                       c.purchaseDate, QString(), &c.id);
+            });
+            if (c.id > 0) {
+                r.esperado.insert(c.id, c);
+                vivos.append(c.id);
+            }
+        } else if (tirada < 65) {
+            // La cantidad y la ubicación siempre cambian, así se nota si se pierde
+            Component &c = r.esperado[vivos[azar.bounded(vivos.size())]];
+            c.quantity = (c.quantity + 1 + azar.bounded(50)) % 100;
+            c.location = QString("Estante E%1-%2 (movido)").arg(n).arg(i);
+            medir(r, "modificacion", [&] {
+                return db.actualizarComponente(c.id, c.name, c.type, c.quantity,
+                                               c.location, c.purchaseDate);
+            });
+        } else if (tirada < 80) {
+            // Todos los campos dependen de (escritor, operación): una fila que
+            // mezclara dos escrituras no coincidiría con ninguna
+            Escritura w;
+            w.valor = ctx.compartidas[azar.bounded(ctx.compartidas.size())];
+            w.valor.type = tipos[(n + i) % tipos.size()];
+            w.valor.quantity = n * operaciones + i;
+            w.valor.location = QString("Estante común, escritor %1, escritura %2").arg(n).arg(i);
+            w.valor.purchaseDate = hoy.addDays(-(n * 7 + i % 7));
+            bool ok = false;
+            w.inicio = ctx.reloj.nsecsElapsed();
+            medir(r, "compartida", [&] {
+                return ok = db.actualizarComponente(w.valor.id, w.valor.name, w.valor.type,
+                                                    w.valor.quantity, w.valor.location,
+                                                    w.valor.purchaseDate);
+            });
+            w.fin = ctx.reloj.nsecsElapsed();
+            if (ok) r.compartidas.append(w);
+        } else {
+            const int pos = azar.bounded(vivos.size());
+            const qint64 id = vivos[pos];
+            vivos.remove(pos);
+            r.esperado.remove(id);
+            medir(r, "baja", [&] { return db.eliminarComponente(id); });
+        }
+    }
+}
+
+// Lector: búsquedas por texto y consultas por rango de fechas hasta que acaben
+// los escritores. Las consultas por fecha se validan (dentro del rango y en orden)
+static void lector(Contexto &ctx, int n, Resultado &r)
+{
+    DatabaseManager db;
+    if (!abrir(db, ctx)) {
+        r.errores << QString("El lector %1 no pudo abrir la base de datos").arg(n);
+        return;
+    }
+
+    QRandomGenerator azar(2000 + n);
+    const QDate hoy = QDate::currentDate();
+    while (!ctx.terminar) {
+        const QString texto = QString("Escritor %1").arg(azar.bounded(8));
+        medir(r, "busqueda", [&] {
+            db.searchComponents(texto);
+            return true;
+        });
+
+        const QDate desde = hoy.addDays(-azar.bounded(2000));
+        const QDate hasta = desde.addDays(90);
+        medir(r, "rango_fechas", [&] {
+            const QVector<Component> filas = db.componentsPurchasedBetween(desde, hasta);
+            for (int i = 0; i < filas.size(); ++i) {
+                const QDate &fecha = filas[i].purchaseDate;
+                if (fecha < desde || fecha > hasta) return false;
+                if (i > 0 && fecha < filas[i - 1].purchaseDate) return false;
+            }
+            return true;
+        });
+    }
+}
+
+// Exportador: exporta el diario de cambios de forma periódica y una última vez
+// cuando ya han terminado los escritores
+static void exportador(Contexto &ctx, const QString &dir, QStringList &archivos, Resultado &r)
+{
+    DatabaseManager db;
+    if (!abrir(db, ctx)) {
+        r.errores << "El exportador no pudo abrir la base de datos";
+        return;
+    }
+
+    auto exportar = [&] {
+        const QString ruta = QDir(dir).filePath(QString("cambios_%1.jsonl").arg(archivos.size()));
+        medir(r, "exportacion", [&] {
+            return ChangeExporter::exportar(db, ruta, ChangeExporter::JsonLines, CONSUMIDOR);
+        });
+        archivos << ruta;
+    };
+    while (!ctx.terminar) {
+        exportar();
+        QThread::msleep(20);
+    }
+    exportar();
+}
+
+// Compara dos componentes campo a campo
+static bool iguales(const Component &a, const Component &b)
+{
+    return a.id == b.id && a.name == b.name && a.type == b.type && a.quantity == b.quantity
+        && a.location == b.location && a.purchaseDate == b.purchaseDate;
+}
+
+// Comprueba una fila compartida: su valor final tiene que ser una de las escrituras
+// confirmadas (o el inicial si no hubo ninguna) y ninguna otra escritura confirmada
+// puede haber empezado después de que acabara esa, porque entonces se confirmó
+// más tarde y debería haberla sustituido
+static void compararCompartida(const Component &inicial, const Component &actual,
+                               const QVector<Escritura> &escrituras, QStringList &fallos)
+{
+    if (escrituras.isEmpty()) {
+        if (!iguales(inicial, actual)) {
+            fallos << QString("Fila compartida %1: cambió sin escrituras confirmadas")
+                          .arg(inicial.id);
+        }
+        return;
+    }
+
+    qint64 ultimoInicio = 0;
+    for (const Escritura &w : escrituras) ultimoInicio = qMax(ultimoInicio, w.inicio);
+    const auto encontrada = std::find_if(escrituras.cbegin(), escrituras.cend(),
+                                         [&](const Escritura &w) {
+                                             return iguales(w.valor, actual);
+                                         });
+    if (encontrada == escrituras.cend()) {
+        fallos << QString("Fila compartida %1: el valor final (%2) no es ninguna escritura "
+                          "confirmada")
+                      .arg(inicial.id).arg(actual.location);
+    } else if (encontrada->fin < ultimoInicio) {
+        fallos << QString("Actualización perdida: la fila compartida %1 conserva \"%2\", "
+                          "pero otra escritura confirmada empezó %3 ms después de acabar esa")
+                      .arg(inicial.id).arg(actual.location)
+                      .arg((ultimoInicio - encontrada->fin) / 1e6, 0, 'f', 2);
+    }
+}
+
+// Compara el estado esperado con los componentes leídos y anota las diferencias
+static void compararEstado(const QString &que, const QMap<ClaveComponente, Component> &esperado,
+                           const QVector<Component> &real, QStringList &fallos)
+{
+    const QMap<ClaveComponente, Component> leidos = porClave(real);
+
+    int diferencias = 0;
+    auto anotar = [&](const QString &mensaje) {
+        if (++diferencias <= MAX_DIFERENCIAS) fallos << que + ": " + mensaje;
+    };
+    for (auto it = esperado.constBegin(); it != esperado.constEnd(); ++it) {
+        const auto encontrado = leidos.constFind(it.key());
+        if (encontrado == leidos.constEnd()) {
+            anotar(QString("falta el componente %1").arg(it.key().second));
+        } else if (!iguales(it.value(), encontrado.value())) {
+            anotar(QString("el componente %1 no tiene los últimos valores escritos")
+                       .arg(it.key().second));
+        }
+    }
+    for (auto it = leidos.constBegin(); it != leidos.constEnd(); ++it) {
+        if (!esperado.contains(it.key())) {
+            anotar(QString("sobra el componente %1").arg(it.key().second));
+        }
+    }
+    if (diferencias > MAX_DIFERENCIAS) {
+        fallos << QString("%1: %2 diferencias en total").arg(que).arg(diferencias);
+    }
+}
+
+// Comprueba que ComponentModel muestra exactamente lo que hay en la base de datos
+static void compararModelo(ComponentModel &modelo, const QVector<Component> &real,
+                           const QString &ruta, QStringList &fallos)
+{
+    modelo.refresh();
+    if (modelo.rowCount() != real.size()) {
+        fallos << QString("Modelo: %1 filas, la base de datos tiene %2")
+                      .arg(modelo.rowCount()).arg(real.size());
+        return;
+    }
+
+    int diferencias = 0;
+    qint64 suma = 0;
+    for (int row = 0; row < modelo.rowCount(); ++row) {
+        const Component &c = modelo.component(row);
+        suma += c.quantity;
+        const bool coincide = iguales(c, real[row])
+            && modelo.data(modelo.index(row, 0)).toLongLong() == c.id
+            && modelo.data(modelo.index(row, 3)).toInt() == c.quantity
+            && modelo.data(modelo.index(row, 5)).toDate() == c.purchaseDate;
+        if (!coincide && ++diferencias <= MAX_DIFERENCIAS) {
+            fallos << QString("Modelo: la fila %1 no coincide con la base de datos").arg(row);
+        }
+    }
+
+    // Recuento independiente, con una conexión propia y sin pasar por DatabaseManager
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "estres_verificacion");
+        db.setDatabaseName(ruta);
+        QSqlQuery query(db);
+        if (!db.open()
+            || !query.exec("SELECT COUNT(*), COALESCE(SUM(quantity), 0) FROM components")
+            || !query.next()) {
+            fallos << "No se pudo hacer el recuento de verificación";
+        } else if (query.value(0).toInt() != modelo.rowCount()
+                   || query.value(1).toLongLong() != suma) {
+            fallos << QString("Modelo: %1 filas y %2 unidades; la tabla tiene %3 y %4")
+                          .arg(modelo.rowCount()).arg(suma)
+                          .arg(query.value(0).toInt()).arg(query.value(1).toLongLong());
+        }
+    }
+    QSqlDatabase::removeDatabase("estres_verificacion");
+}
+
+// Calcula el resumen de una operación
+static Estadistica resumir(QVector<qint64> tiempos, double segundos)
+{
+    std::sort(tiempos.begin(), tiempos.end());
+    Estadistica e;
+    e.operaciones = tiempos.size();
+    e.p50 = percentil(tiempos, 0.50);
+    e.p99 = percentil(tiempos, 0.99);
+    e.maximo = percentil(tiempos, 1.0);
+    e.rendimiento = segundos > 0 ? tiempos.size() / segundos : 0;
+    return e;
+}
+
+// Imprime el resumen y el histograma de latencias (intervalos en potencias de 2)
+static void informar(QTextStream &out, const QString &operacion, const Estadistica &e,
+                     const QVector<qint64> &tiempos)
+{
+    out << QString("%1: %2 ops, %3 ops/s, p50 %4 ms, p99 %5 ms, máx %6 ms\n")
+               .arg(operacion, -14).arg(e.operaciones).arg(e.rendimiento, 0, 'f', 1)
+               .arg(e.p50, 0, 'f', 2).arg(e.p99, 0, 'f', 2).arg(e.maximo, 0, 'f', 2);
+
+    // El primer intervalo agrupa todo lo que dura hasta 64 µs
+    QVector<int> intervalos;
+    for (qint64 us : tiempos) {
+        const int i = us <= 64 ? 0 : int(std::ceil(std::log2(double(us)))) - 6;
+        if (intervalos.size() <= i) intervalos.resize(i + 1);
+        ++intervalos[i];
+    }
+    const int mayor = intervalos.isEmpty() ? 0 : *std::max_element(intervalos.begin(), intervalos.end());
+    for (int i = 0; i < intervalos.size(); ++i) {
+        const int barra = mayor > 0 ? (intervalos[i] * 40 + mayor - 1) / mayor : 0;
+        out << QString("    <= %1 µs ").arg(qint64(64) << i, 9)
+            << QString(barra, '#') << ' ' << intervalos[i] << '\n';
+    }
+}
+
+// Anota si una operación empeora respecto a su referencia. Las latencias admitidas
+// son las de la referencia multiplicadas por 'escala' (contención esperada) y por
+// la tolerancia, más el margen; el rendimiento admitido es el de la referencia
+// dividido por ambos factores. Los valores de referencia a 0 no se comparan
+static void compararCon(const QString &que, const QString &operacion, const Estadistica &e,
+                        const Estadistica &ref, double escala, double tolerancia,
+                        double margen, QStringList &fallos)
+{
+    if (e.operaciones < MIN_MUESTRAS || ref.operaciones < MIN_MUESTRAS) return;
+
+    const double limiteP50 = ref.p50 * escala * tolerancia + margen;
+    const double limiteP99 = ref.p99 * escala * tolerancia + margen;
+    if (ref.p50 > 0 && e.p50 > limiteP50) {
+        fallos << QString("%1, %2: p50 %3 ms supera el límite %4 ms (referencia %5 ms)")
+                      .arg(que, operacion).arg(e.p50).arg(limiteP50).arg(ref.p50);
+    }
+    if (ref.p99 > 0 && e.p99 > limiteP99) {
+        fallos << QString("%1, %2: p99 %3 ms supera el límite %4 ms (referencia %5 ms)")
+                      .arg(que, operacion).arg(e.p99).arg(limiteP99).arg(ref.p99);
+    }
+    if (e.rendimiento < ref.rendimiento / (escala * tolerancia)) {
+        fallos << QString("%1, %2: %3 ops/s por debajo de la referencia %4 ops/s")
+                      .arg(que, operacion).arg(e.rendimiento, 0, 'f', 1)
+                      .arg(ref.rendimiento, 0, 'f', 1);
+    }
+}
+
+// Parámetros de la ejecución, para no comparar con una referencia de otro perfil
+static QString perfil(int escritores, int lectores, int operaciones, int filas)
+{
+    return QString("%1 escritores, %2 lectores, %3 operaciones, %4 filas")
+        .arg(escritores).arg(lectores).arg(operaciones).arg(filas);
+}
+
+// Guarda los resultados como referencia, con la máquina y el perfil en que se midieron.
+// Se compara con la tolerancia y el margen de la línea de órdenes
+static void guardarReferencia(QSettings &referencia, const QString &perfilActual,
+                              const QMap<QString, Estadistica> &resumen)
+{
+    referencia.clear();
+    referencia.setValue("general/origen",
+                        QString("Medido en %1 (%2, %3, Qt %4)")
+                            .arg(QSysInfo::machineHostName(), QSysInfo::prettyProductName(),
+                                 QSysInfo::currentCpuArchitecture(), qVersion()));
+    referencia.setValue("general/perfil", perfilActual);
+    for (auto it = resumen.constBegin(); it != resumen.constEnd(); ++it) {
+        referencia.beginGroup(it.key());
+        referencia.setValue("operaciones", it.value().operaciones);
+        referencia.setValue("p50", it.value().p50);
+        referencia.setValue("p99", it.value().p99);
+        referencia.setValue("rendimiento", it.value().rendimiento);
+        referencia.endGroup();
+    }
+}
+
+// Compara con una referencia guardada, que tiene que ser del mismo perfil. El
+// archivo puede fijar su propia tolerancia y margen (un presupuesto usa 1 y 0,
+// es decir, límites absolutos); si no, se usan los de la línea de órdenes.
+// Una operación medida que no figura en el archivo también es un fallo, para que
+// una operación nueva no quede sin límite
+static void compararConGuardada(QSettings &referencia, const QString &perfilActual,
+                                const QMap<QString, Estadistica> &resumen, double tolerancia,
+                                QTextStream &out, QStringList &fallos)
+{
+    if (referencia.status() != QSettings::NoError || !referencia.contains("general/perfil")) {
+        fallos << "No se pudo leer la referencia " + referencia.fileName();
+        return;
+    }
+    const QString perfilGuardado = referencia.value("general/perfil").toString();
+    if (perfilGuardado != perfilActual) {
+        fallos << QString("La referencia %1 es de otro perfil (%2)")
+                      .arg(referencia.fileName(), perfilGuardado);
+        return;
+    }
+    tolerancia = referencia.value("general/tolerancia", tolerancia).toDouble();
+    const double margen = referencia.value("general/margen_ms", MARGEN_MS).toDouble();
+    out << "Referencia " << referencia.fileName() << ": "
+        << referencia.value("general/origen").toString() << '\n';
+
+    for (auto it = resumen.constBegin(); it != resumen.constEnd(); ++it) {
+        if (!referencia.childGroups().contains(it.key())) {
+            fallos << QString("La referencia no tiene límites para %1").arg(it.key());
+            continue;
+        }
+        referencia.beginGroup(it.key());
+        Estadistica ref;
+        ref.operaciones = referencia.value("operaciones", MIN_MUESTRAS).toInt();
+        ref.p50 = referencia.value("p50").toDouble();
+        ref.p99 = referencia.value("p99").toDouble();
+        ref.rendimiento = referencia.value("rendimiento").toDouble();
+        referencia.endGroup();
+        compararCon("Referencia guardada", it.key(), it.value(), ref, 1.0, tolerancia, margen,
+                    fallos);
+    }
+}
+
+// Abre a la vez desde varios hilos una base de datos con el esquema antiguo
+// (purchase_date TEXT, sin diario de cambios). Todas las aperturas deben funcionar,
+// las fechas deben migrarse bien y el diario debe sembrarse una sola vez
+static QStringList aperturasConcurrentes(int filas)
+{
+    QStringList fallos;
+    QTemporaryDir dir;
+    const QString ruta = dir.filePath("antigua.db");
+    const QDate inicio = QDate::currentDate().addDays(-filas);
+
+    bool ok = dir.isValid();
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "estres_antigua");
+        db.setDatabaseName(ruta);
+        QSqlQuery query(db);
+        ok = ok && db.open() && db.transaction()
+            && query.exec("CREATE TABLE components ("
+                          "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+                          "name TEXT NOT NULL,"
+                          "type TEXT NOT NULL,"
+                          "quantity INTEGER NOT NULL,"
+                          "location TEXT NOT NULL,"
+                          "purchase_date TEXT NOT NULL)")
+            && query.prepare("INSERT INTO components (name, type, quantity, location, "
+                             "purchase_date) VALUES (?, 'Resistencia', 1, 'Estante', ?)");
+        for (int i = 0; ok && i < filas; ++i) {
+            query.addBindValue(QString("Componente antiguo %1").arg(i));
+            query.addBindValue(inicio.addDays(i).toString(Qt::ISODate));
+            ok = query.exec();
+        }
+        ok = ok && db.commit();
+    }
+    QSqlDatabase::removeDatabase("estres_antigua");
+    if (!ok) return {"Aperturas concurrentes: no se pudo crear la base de datos antigua"};
+
+    // Todos los hilos esperan a estar listos y abren a la vez
+    QSemaphore listos;
+    QSemaphore salida;
+    QVector<bool> abiertas(APERTURAS_CONCURRENTES, false);
+    QVector<QThread *> hilos;
+    for (int i = 0; i < APERTURAS_CONCURRENTES; ++i) {
+        hilos << QThread::create([&, i] {
+            DatabaseManager db;
+            listos.release();
+            salida.acquire();
+            abiertas[i] = db.initialize(ruta);
+        });
+    }
+    for (QThread *hilo : hilos) hilo->start();
+    listos.acquire(APERTURAS_CONCURRENTES);
+    salida.release(APERTURAS_CONCURRENTES);
+    for (QThread *hilo : hilos) {
+        hilo->wait();
+        delete hilo;
+    }
+    const int fallidas = int(std::count(abiertas.cbegin(), abiertas.cend(), false));
+    if (fallidas > 0) {
+        fallos << QString("Aperturas concurrentes: %1 de %2 no pudieron abrir la base de datos")
+                      .arg(fallidas).arg(APERTURAS_CONCURRENTES);
+    }
+
+    DatabaseManager db;
+    if (!db.initialize(ruta)) {
+        fallos << "Aperturas concurrentes: la base de datos migrada no se puede abrir";
+        return fallos;
+    }
+    const QVector<Component> componentes = db.getAllComponents();
+    if (componentes.size() != filas) {
+        fallos << QString("Aperturas concurrentes: %1 componentes tras la migración, había %2")
+                      .arg(componentes.size()).arg(filas);
+    }
+    int diferencias = 0;
+    for (const Component &c : componentes) {
+        const QDate esperada = inicio.addDays(int(c.id) - 1);
+        if (c.purchaseDate != esperada && ++diferencias <= MAX_DIFERENCIAS) {
+            fallos << QString("Aperturas concurrentes: el componente %1 tiene fecha %2, no %3")
+                          .arg(c.id).arg(c.purchaseDate.toString(Qt::ISODate),
+                                         esperada.toString(Qt::ISODate));
+        }
+    }
+    {
+        QSqlDatabase conexion = QSqlDatabase::addDatabase("QSQLITE", "estres_antigua");
+        conexion.setDatabaseName(ruta);
+        QSqlQuery query(conexion);
+        if (!conexion.open()
+            || !query.exec("SELECT (SELECT COUNT(*) FROM component_changes), "
+                           "(SELECT COUNT(*) FROM sqlite_master WHERE type = 'trigger')")
+            || !query.next()) {
+            fallos << "Aperturas concurrentes: no se pudo leer el diario de cambios";
+        } else if (query.value(0).toInt() != filas || query.value(1).toInt() != 3) {
+            fallos << QString("Aperturas concurrentes: el diario tiene %1 altas y hay %2 "
+                              "triggers; se esperaban %3 y 3")
+                          .arg(query.value(0).toInt()).arg(query.value(1).toInt()).arg(filas);
+        }
+    }
+    QSqlDatabase::removeDatabase("estres_antigua");
+    return fallos;
+}
+
+// Ejecuta la prueba con el número de hilos indicado sobre una base de datos nueva
+// y comprueba el estado final
+static Ejecucion ejecutar(int escritores, int lectores, int operaciones, int filas)
+{
+    Ejecucion resultado;
+    QTemporaryDir dir;
+    Contexto ctx;
+    ctx.ruta = dir.filePath("inventario.db");
+
+    DatabaseManager db;
+    if (!dir.isValid() || !db.initialize(ctx.ruta) || !poblarComponentes(ctx.ruta, filas)) {
+        resultado.fallos << "No se pudo preparar la base de datos";
+        return resultado;
+    }
+    for (int i = 0; i < FILAS_COMPARTIDAS; ++i) {
+        Component c;
+        c.name = QString("Fila compartida %1").arg(i);
+        c.type = "Consumible";
+        c.quantity = 0;
+        c.location = "Estante común";
+        c.purchaseDate = QDate::currentDate();
+        c.site = db.sites().first();
+        db.addComponent(c.name, c.type, c.quantity, c.location, c.purchaseDate, QString(), &c.id);
+        if (c.id > 0) ctx.compartidas << c;
+    }
+    if (ctx.compartidas.size() != FILAS_COMPARTIDAS) {
+        resultado.fallos << "No se pudieron crear las filas compartidas";
+        return resultado;
+    }
+
+    // Un resultado por hilo: escritores, lectores y el exportador al final
+    const int hilos = escritores + lectores + 1;
+    QVector<Resultado> resultados(hilos);
+    QStringList archivos;
+    QVector<QThread *> trabajadores;
+    for (int i = 0; i < escritores; ++i) {
+        trabajadores << QThread::create([&, i] { escritor(ctx, i, operaciones, resultados[i]); });
+    }
+    for (int i = 0; i < lectores; ++i) {
+        trabajadores << QThread::create([&, i] { lector(ctx, i, resultados[escritores + i]); });
+    }
+    trabajadores << QThread::create([&] {
+        exportador(ctx, dir.path(), archivos, resultados[hilos - 1]);
+    });
+    ctx.reloj.start();
+    for (QThread *hilo : trabajadores) hilo->start();
+    ctx.listos.acquire(hilos);
+
+    // Estado inicial y modelo, en el hilo principal
+    QMap<ClaveComponente, Component> esperado = porClave(db.getAllComponents());
+    ComponentModel modelo(&db);
+
+    auto escribiendo = [&] {
+        for (int i = 0; i < escritores; ++i) {
+            if (!trabajadores[i]->isFinished()) return true;
+        }
+        return false;
+    };
+
+    // El hilo principal recarga el modelo mientras haya escritores activos
+    Resultado principal;
+    QElapsedTimer reloj;
+    reloj.start();
+    ctx.salida.release(hilos);
+    do {
+        medir(principal, "carga_modelo", [&] {
+            modelo.refresh();
+            return true;
+        });
+    } while (escribiendo());
+    resultado.segundos = reloj.nsecsElapsed() / 1e9;
+
+    ctx.terminar = true;
+    for (QThread *hilo : trabajadores) {
+        hilo->wait();
+        delete hilo;
+    }
+
+    // --- Correctitud ---
+    QStringList &fallos = resultado.fallos;
+    resultados.append(principal);
+    QMap<qint64, QVector<Escritura>> escrituras;
+    for (const Resultado &r : resultados) {
+        for (const QString &error : r.errores) {
+            if (fallos.size() < MAX_DIFERENCIAS) fallos << error;
+        }
+        for (auto it = r.esperado.constBegin(); it != r.esperado.constEnd(); ++it) {
+            esperado.insert(clave(it.value()), it.value());
+        }
+        for (const Escritura &w : r.compartidas) escrituras[w.valor.id].append(w);
+        for (auto it = r.muestras.constBegin(); it != r.muestras.constEnd(); ++it) {
+            resultado.muestras[it.key()] += it.value();
+        }
+    }
+
+    // Cada fila compartida debe conservar la última escritura confirmada; una vez
+    // comprobada, se espera tal cual en el resto de comparaciones
+    const QVector<Component> estadoFinal = db.getAllComponents();
+    const QMap<ClaveComponente, Component> leidos = porClave(estadoFinal);
+    for (const Component &inicial : ctx.compartidas) {
+        const auto actual = leidos.constFind(clave(inicial));
+        if (actual == leidos.constEnd()) {
+            fallos << QString("Falta la fila compartida %1").arg(inicial.id);
+            continue;
+        }
+        compararCompartida(inicial, actual.value(), escrituras.value(inicial.id), fallos);
+        esperado.insert(actual.key(), actual.value());
+    }
+
+    compararEstado("Actualizaciones perdidas", esperado, estadoFinal, fallos);
+    compararModelo(modelo, estadoFinal, ctx.ruta, fallos);
+    compararEstado("Exportación de cambios", reproducirExportaciones(archivos, fallos), estadoFinal, fallos);
+    resultado.componentes = estadoFinal.size();
+    return resultado;
+}
+
+// Calcula e imprime el resumen de cada operación de una ejecución
+static QMap<QString, Estadistica> resumirEjecucion(QTextStream &out, const QString &titulo,
+                                                  const Ejecucion &ejecucion)
+{
+    out << QString("%1: %2 s, %3 componentes al final\n")
+               .arg(titulo).arg(ejecucion.segundos, 0, 'f', 2).arg(ejecucion.componentes);
+
+    QMap<QString, Estadistica> resumen;
+    for (auto it = ejecucion.muestras.constBegin(); it != ejecucion.muestras.constEnd(); ++it) {
+        resumen.insert(it.key(), resumir(it.value(), ejecucion.segundos));
+        informar(out, it.key(), resumen.value(it.key()), it.value());
+    }
+    return resumen;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Prueba de concurrencia y latencia de la capa de datos");
+    parser.addHelpOption();
+    QCommandLineOption optEscritores("escritores", "Hilos escritores.", "N", "4");
+    QCommandLineOption optLectores("lectores", "Hilos lectores.", "N", "2");
+    QCommandLineOption optOperaciones("operaciones", "Operaciones por escritor.", "N", "300");
+    QCommandLineOption optFilas("filas", "Componentes iniciales.", "N", "2000");
+    QCommandLineOption optTolerancia("tolerancia", "Factor de empeoramiento admitido.",
+                                     "factor", "2");
+    QCommandLineOption optReferencia("referencia",
+                                     "Archivo .ini con los límites de latencia (presupuesto "
+                                     "o medición guardada).",
+                                     "archivo");
+    QCommandLineOption optGuardar("guardar-referencia",
+                                  "Guarda los resultados en --referencia en lugar de comparar.");
+    parser.addOptions({optEscritores, optLectores, optOperaciones, optFilas,
+                       optTolerancia, optReferencia, optGuardar});
+    parser.process(app);
+
+    const int escritores = qMax(1, parser.value(optEscritores).toInt());
+    const int lectores = qMax(0, parser.value(optLectores).toInt());
+    const int operaciones = qMax(1, parser.value(optOperaciones).toInt());
+    const int filas = qMax(0, parser.value(optFilas).toInt());
+    const double tolerancia = qMax(1.0, parser.value(optTolerancia).toDouble());
+
+    QStringList fallos = aperturasConcurrentes(filas);
+
+    // Referencia: un hilo de cada tipo, con las mismas operaciones por escritor
+    const int lectoresReferencia = qMin(1, lectores);
+    const Ejecucion referencia = ejecutar(1, lectoresReferencia, operaciones, filas);
+    const Ejecucion completa = ejecutar(escritores, lectores, operaciones, filas);
+
+    for (const QString &fallo : referencia.fallos) fallos << "Referencia: " + fallo;
+    fallos << completa.fallos;
+
+    // --- Latencias y rendimiento ---
+    const QMap<QString, Estadistica> resumenReferencia =
+        resumirEjecucion(out, "Referencia (1 escritor)", referencia);
+    const QMap<QString, Estadistica> resumen =
+        resumirEjecucion(out, QString("%1 escritores, %2 lectores").arg(escritores).arg(lectores),
+                         completa);
+
+    // Cada hilo más compite por el bloqueo de escritura de SQLite
+    const double escala = double(escritores + lectores + 1) / (1 + lectoresReferencia + 1);
+    for (auto it = resumen.constBegin(); it != resumen.constEnd(); ++it) {
+        if (resumenReferencia.contains(it.key())) {
+            compararCon("Ejecución de referencia", it.key(), it.value(),
+                        resumenReferencia.value(it.key()), escala, tolerancia, MARGEN_MS,
+                        fallos);
+        }
+    }
+
+    if (parser.isSet(optReferencia)) {
+        QSettings guardada(parser.value(optReferencia), QSettings::IniFormat);
+        const QString perfilActual = perfil(escritores, lectores, operaciones, filas);
+        if (parser.isSet(optGuardar)) {
+            guardarReferencia(guardada, perfilActual, resumen);
+            out << "Referencia guardada en " << parser.value(optReferencia) << '\n';
+        } else {
+            compararConGuardada(guardada, perfilActual, resumen, tolerancia, out, fallos);
+        }
+    }
+
+    if (!fallos.isEmpty()) {
+        for (const QString &fallo : fallos) out << "FALLO: " << fallo << '\n';
+        return 1;
+    }
+    out << "Correcto\n";
+    return 0;
+}
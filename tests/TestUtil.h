@@ -0,0 +1,39 @@
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+#include "DataHub/DBControl.h"
+#include <QMap>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+
+// Utilidades comunes de las pruebas y de los benchmarks
+
+// Tipos de componente de los datos de prueba
+QStringList tiposDePrueba();
+
+// Inserta 'filas' componentes en una sola transacción, con una conexión propia, en
+// una base de datos cuyas tablas ya existen. Las fechas de compra se reparten por
+// los últimos 2000 días y los nombres son largos (para que la tabla los recorte)
+bool poblarComponentes(const QString &ruta, int filas);
+
+// Percentil p (entre 0 y 1) de una lista de tiempos en µs ya ordenada, en ms
+double percentil(const QVector<qint64> &ordenados, double p);
+
+// Clave de un componente: los IDs se repiten entre almacenes, así que van con el sitio
+using ClaveComponente = QPair<QString, qint64>;
+
+// Clave (sitio, ID) de un componente
+ClaveComponente clave(const Component &componente);
+
+// Componentes indexados por su clave
+QMap<ClaveComponente, Component> porClave(const QVector<Component> &componentes);
+
+// Reconstruye el inventario aplicando en orden los cambios exportados (JSON Lines),
+// como lo haría un consumidor: "reset" descarta lo recibido de ese sitio, "delete"
+// quita el componente y "insert"/"update" lo reemplazan. Los archivos que no
+// existen se saltan; los que no se pueden leer se anotan en fallos.
+QMap<ClaveComponente, Component> reproducirExportaciones(const QStringList &archivos,
+                                                        QStringList &fallos);
+
+#endif // TESTUTIL_H